@@ -0,0 +1,556 @@
+/**
+ * @author Eli Fivelzon, eli.fivelzon@mail.huji.ac.il
+ * VLConcurrentVector<T>: an append only vector many threads push_back into without a lock,
+ * while consumers iterate the prefix of the elements which are already complete. It grows by
+ * the doubling segments of VLSegmentedVector, so no element ever moves under a reader.
+ */
+#ifndef VLCONCURRENT_VECTOR_HPP
+#define VLCONCURRENT_VECTOR_HPP
+#include "VLSegmentedVector.hpp"
+#include <atomic>
+
+/**
+ * The num of elements an Appender stages before claiming their slots at once.
+ */
+#define VLCONCURRENT_BATCH_SIZE 64
+
+/**
+ * Padding which keeps the counters producers and consumers write off each other's cache line.
+ */
+#define VLCONCURRENT_CACHE_LINE 64
+
+/**
+ * @class VLConcurrentVector: Multi producer append only vector. push_back allocates the segment of
+ * the next slot if no thread did yet (racing threads settle it with a compare exchange, the losers
+ * free theirs), claims the slot with one fetch_add on the claimed count, constructs the element
+ * and only then sets its ready flag. size() is the published prefix: the elements before it are
+ * all complete, so begin()/end() and operator[] below size() are safe while producers keep
+ * appending. A producer stalled between claiming and constructing holds the prefix back, never the
+ * other producers. Appender stages elements in an inline VLVector and claims a whole batch with
+ * one fetch_add, for loops which push a lot. A segment allocation which throws does so before
+ * claiming (see _claim), so the vector goes on publishing once memory is back; reserve() up front
+ * keeps the allocations out of the producers. clear() and the destructor must not run concurrently
+ * with anything else.
+ * @tparam T: Must be nothrow move constructible, so a claimed slot is always filled.
+ * @tparam Allocator
+ */
+template<class T, class Allocator = std::allocator<T>>
+class VLConcurrentVector: private vl_detail::AllocatorHolder<Allocator>
+{
+	static_assert(std::is_same<typename Allocator::value_type, T>::value,
+				  "Allocator::value_type must be T.");
+	static_assert(std::is_nothrow_move_constructible<T>::value,
+				  "T must be nothrow move constructible.");
+
+	template<class, class>
+	friend class vl_detail::SegmentIterator;
+public:
+	typedef T value_type;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef Allocator allocator_type;
+	typedef vl_detail::SegmentIterator<const T, const VLConcurrentVector> const_iterator;
+
+	template<std::size_t BatchSize = VLCONCURRENT_BATCH_SIZE>
+	class Appender;
+private:
+	typedef std::allocator_traits<Allocator> _AllocTraits;
+	typedef typename _AllocTraits::template rebind_alloc<unsigned char> _ByteAllocator;
+	typedef std::allocator_traits<_ByteAllocator> _ByteTraits;
+	typedef vl_detail::SegmentLayout<0> _Layout;
+
+	static_assert(alignof(T) <= vl_detail::AllocatorAlignment<_ByteAllocator>::value,
+				  "Allocator can't align T.");
+	static_assert(alignof(std::atomic<bool>) == 1,
+				  "The ready flags must pack after the elements.");
+
+	/**
+	 * Segment k holds _Layout::segmentSize(k) elements followed by their ready flags.
+	 */
+	std::atomic<unsigned char*> _segments[_Layout::maxSegments];
+	alignas(VLCONCURRENT_CACHE_LINE) std::atomic<std::size_t> _claimed;
+
+	/**
+	 * A lower bound of the published prefix, which size() advances.
+	 */
+	alignas(VLCONCURRENT_CACHE_LINE) mutable std::atomic<std::size_t> _published;
+
+	Allocator& _alloc() { return this->allocator(); }
+
+	const Allocator& _alloc() const { return this->allocator(); }
+
+	/**
+	 * @param segment
+	 * @return The num of bytes of heap segment.
+	 */
+	static std::size_t _segmentBytes(std::size_t segment)
+	{
+		return _Layout::segmentSize(segment) * (sizeof(T) + sizeof(std::atomic<bool>));
+	}
+
+	/**
+	 * @param memory: Heap segment.
+	 * @param segment: Its index.
+	 * @return The ready flags of its elements.
+	 */
+	static std::atomic<bool>* _flags(unsigned char *memory, std::size_t segment)
+	{
+		return reinterpret_cast<std::atomic<bool>*>(memory + _Layout::segmentSize(segment) *
+				sizeof(T));
+	}
+
+	/**
+	 * @param segment
+	 * @return Heap segment, allocated by this thread if no other thread did.
+	 */
+	unsigned char* _segment(std::size_t segment);
+
+	/**
+	 * @param index: Less than capacity().
+	 * @return The slot of element index and the end of its segment.
+	 */
+	std::pair<T*, T*> _locate(std::size_t index) const
+	{
+		std::pair<std::size_t, std::size_t> slot = _Layout::locate(index);
+		T* segment = reinterpret_cast<T*>(_segments[slot.first].load(
+				std::memory_order_acquire));
+		return {segment + slot.second, segment + _Layout::segmentSize(slot.first)};
+	}
+
+	/**
+	 * @param index
+	 * @return Whether element index is constructed, visible to this thread if so.
+	 */
+	bool _ready(std::size_t index) const
+	{
+		std::pair<std::size_t, std::size_t> slot = _Layout::locate(index);
+		unsigned char* segment = _segments[slot.first].load(std::memory_order_acquire);
+		return segment != nullptr &&
+			   _flags(segment, slot.first)[slot.second].load(std::memory_order_acquire);
+	}
+
+	/**
+	 * Allocate the segments of the slots [first, first + count) no thread allocated yet.
+	 * @param first
+	 * @param count: Positive.
+	 */
+	void _allocateSlots(std::size_t first, std::size_t count)
+	{
+		std::size_t last = _Layout::locate(first + count - 1).first;
+		for (std::size_t segment = _Layout::locate(first).first; segment <= last; ++segment)
+		{
+			_segment(segment);
+		}
+	}
+
+	/**
+	 * Claim count consecutive slots with one fetch_add. The segments of the next count slots
+	 * are allocated first, so an allocation which throws claims nothing and leaves no hole
+	 * before the later elements. Only a claim which racing producers push past those segments
+	 * allocates after claiming, and a throw there leaves its slots unpublished: reserve() up
+	 * front rules that out.
+	 * @param count: Positive.
+	 * @return The first of the slots claimed for this thread, their segments allocated.
+	 */
+	std::size_t _claim(std::size_t count)
+	{
+		std::size_t next = _claimed.load(std::memory_order_relaxed);
+		if (next > max_size() - count)
+		{
+			throw std::length_error(LENGTH_ERR_MSG);
+		}
+		_allocateSlots(next, count);
+		std::size_t first = _claimed.fetch_add(count, std::memory_order_relaxed);
+		if (first > max_size() - count)
+		{
+			throw std::length_error(LENGTH_ERR_MSG);
+		}
+		if (first != next)
+		{
+			// Other producers claimed meanwhile, usually the segment is theirs already.
+			_allocateSlots(first, count);
+		}
+		return first;
+	}
+
+	/**
+	 * Construct element index in its claimed slot, whose segment exists, and publish it.
+	 * @param index
+	 * @param args: The constructor arguments, constructing must not throw.
+	 */
+	template<class... Args>
+	void _fill(std::size_t index, Args&&... args);
+
+	/**
+	 * Move count elements to slots of their own, claimed at once. A throw claims and moves
+	 * none of them.
+	 * @param first
+	 * @param count
+	 * @return The index of the first.
+	 */
+	std::size_t _appendMoved(T *first, std::size_t count);
+
+	/**
+	 * Destroy the elements and free the segments.
+	 */
+	void _release() noexcept;
+public:
+	VLConcurrentVector(): VLConcurrentVector(Allocator()) {}
+
+	/**
+	 * @param alloc: The allocator of the segments.
+	 */
+	explicit VLConcurrentVector(const Allocator &alloc):
+			vl_detail::AllocatorHolder<Allocator>(alloc), _claimed(0), _published(0)
+	{
+		for (std::atomic<unsigned char*> &segment: _segments)
+		{
+			segment.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * Shared by the threads, so pinned to its address.
+	 */
+	VLConcurrentVector(const VLConcurrentVector&) = delete;
+
+	VLConcurrentVector& operator=(const VLConcurrentVector&) = delete;
+
+	~VLConcurrentVector() { _release(); }
+
+	/**
+	 * @return The published prefix: elements [0, size()) are complete and stay so.
+	 */
+	std::size_t size() const;
+
+	bool empty() const { return size() == 0; }
+
+	/**
+	 * @return The num of slots claimed so far, complete or not.
+	 */
+	std::size_t claimed_size() const { return _claimed.load(std::memory_order_relaxed); }
+
+	/**
+	 * @return The num of elements the leading allocated segments hold.
+	 */
+	std::size_t capacity() const
+	{
+		std::size_t segments = 0;
+		while (segments < _Layout::maxSegments &&
+			   _segments[segments].load(std::memory_order_acquire) != nullptr)
+		{
+			++segments;
+		}
+		return _Layout::capacity(segments);
+	}
+
+	std::size_t max_size() const
+	{
+		return std::min<std::size_t>(_AllocTraits::max_size(_alloc()), PTRDIFF_MAX / sizeof(T));
+	}
+
+	Allocator get_allocator() const { return _alloc(); }
+
+	/**
+	 * Allocate the segments of the first newCapacity elements. Safe to race with producers.
+	 * @param newCapacity
+	 */
+	void reserve(std::size_t newCapacity);
+
+	/**
+	 * Append an element, safe to race with other producers and with consumers.
+	 * @param args: The constructor arguments, the element is built before claiming its slot
+	 * when constructing may throw.
+	 * @return The index of the element.
+	 */
+	template<class... Args>
+	std::size_t emplace_back(Args&&... args);
+
+	std::size_t push_back(const T &value) { return emplace_back(value); }
+
+	std::size_t push_back(T &&value) { return emplace_back(std::move(value)); }
+
+	/**
+	 * @tparam BatchSize
+	 * @return An Appender of this vector, for one thread.
+	 */
+	template<std::size_t BatchSize = VLCONCURRENT_BATCH_SIZE>
+	Appender<BatchSize> appender() { return Appender<BatchSize>(*this); }
+
+	/**
+	 * @param index: Less than size().
+	 */
+	const T& operator[](std::size_t index) const { return *_locate(index).first; }
+
+	/**
+	 * @param index: Less than size().
+	 */
+	T& operator[](std::size_t index) { return *_locate(index).first; }
+
+	const T& at(std::size_t index) const;
+
+	T& at(std::size_t index);
+
+	/**
+	 * Destroy the elements, not concurrently with anything else. Keeps the segments.
+	 */
+	void clear() noexcept;
+
+	const_iterator begin() const { return const_iterator(this, 0); }
+
+	const_iterator cbegin() const { return begin(); }
+
+	/**
+	 * @return The end of the prefix published at the call, a range for loop reads it once.
+	 */
+	const_iterator end() const { return const_iterator(this, size()); }
+
+	const_iterator cend() const { return end(); }
+};
+
+/**
+ * @class Appender: Per thread staging buffer of a VLConcurrentVector. The elements wait in an
+ * inline VLVector and move to the vector in batches of BatchSize, each claimed with one fetch_add,
+ * so producers share the claimed count's cache line once a batch instead of once an element. The
+ * staged elements aren't visible until flush(), which the destructor calls. A destructor can't
+ * report a segment allocation which fails, so it drops the staged elements then: call flush()
+ * before it to see the throw, or reserve() the vector up front.
+ * @tparam BatchSize
+ */
+template<class T, class Allocator>
+template<std::size_t BatchSize>
+class VLConcurrentVector<T, Allocator>::Appender
+{
+	static_assert(BatchSize > 0, "BatchSize must be positive.");
+private:
+	VLConcurrentVector* _target;
+	VLVector<T, BatchSize, VLRatioGrowth<>, std::size_t, Allocator> _staged;
+public:
+	/**
+	 * @param target: Must outlive the appender.
+	 */
+	explicit Appender(VLConcurrentVector &target): _target(&target), _staged(target._alloc()) {}
+
+	Appender(const Appender&) = delete;
+
+	Appender(Appender &&other): _target(other._target), _staged(std::move(other._staged))
+	{
+		other._staged.clear();
+	}
+
+	Appender& operator=(const Appender&) = delete;
+
+	~Appender()
+	{
+		try
+		{
+			flush();
+		}
+		catch (...)
+		{
+			// The staged elements are destroyed with _staged, see the class comment.
+		}
+	}
+
+	/**
+	 * Stage an element, flushing once BatchSize are staged.
+	 * @param args: The constructor arguments.
+	 */
+	template<class... Args>
+	void emplace_back(Args&&... args)
+	{
+		_staged.emplace_back(std::forward<Args>(args)...);
+		if (_staged.size() == BatchSize)
+		{
+			flush();
+		}
+	}
+
+	void push_back(const T &value) { emplace_back(value); }
+
+	void push_back(T &&value) { emplace_back(std::move(value)); }
+
+	/**
+	 * @return The num of elements staged and not yet in the vector.
+	 */
+	std::size_t staged() const { return _staged.size(); }
+
+	/**
+	 * Move the staged elements to the vector. If a segment allocation throws, they all stay
+	 * staged and nothing is claimed, so flushing again once memory is back publishes them.
+	 */
+	void flush()
+	{
+		if (!_staged.empty())
+		{
+			_target->_appendMoved(_staged.data(), _staged.size());
+			_staged.clear();
+		}
+	}
+};
+
+#define VLCONCURRENT_TEMPLATE template<class T, class Allocator>
+#define VLCONCURRENT_CLASS VLConcurrentVector<T, Allocator>
+
+VLCONCURRENT_TEMPLATE
+unsigned char* VLCONCURRENT_CLASS::_segment(std::size_t segment)
+{
+	unsigned char* memory = _segments[segment].load(std::memory_order_acquire);
+	if (memory != nullptr)
+	{
+		return memory;
+	}
+	_ByteAllocator bytes(_alloc());
+	unsigned char* fresh = _ByteTraits::allocate(bytes, _segmentBytes(segment));
+	std::atomic<bool>* flags = _flags(fresh, segment);
+	for (std::size_t i = 0; i < _Layout::segmentSize(segment); ++i)
+	{
+		new (flags + i) std::atomic<bool>(false);
+	}
+	if (_segments[segment].compare_exchange_strong(memory, fresh, std::memory_order_acq_rel,
+												   std::memory_order_acquire))
+	{
+		return fresh;
+	}
+	// Another thread installed its segment first.
+	_ByteTraits::deallocate(bytes, fresh, _segmentBytes(segment));
+	return memory;
+}
+
+VLCONCURRENT_TEMPLATE
+template<class... Args>
+void VLCONCURRENT_CLASS::_fill(std::size_t index, Args&&... args)
+{
+	std::pair<std::size_t, std::size_t> slot = _Layout::locate(index);
+	unsigned char* memory = _segments[slot.first].load(std::memory_order_acquire);
+	_AllocTraits::construct(_alloc(), reinterpret_cast<T*>(memory) + slot.second,
+							std::forward<Args>(args)...);
+	_flags(memory, slot.first)[slot.second].store(true, std::memory_order_release);
+}
+
+VLCONCURRENT_TEMPLATE
+std::size_t VLCONCURRENT_CLASS::_appendMoved(T *first, std::size_t count)
+{
+	if (count == 0)
+	{
+		return claimed_size();
+	}
+	std::size_t index = _claim(count);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		_fill(index + i, std::move(first[i]));
+	}
+	return index;
+}
+
+VLCONCURRENT_TEMPLATE
+void VLCONCURRENT_CLASS::_release() noexcept
+{
+	clear();
+	_ByteAllocator bytes(_alloc());
+	for (std::size_t segment = 0; segment < _Layout::maxSegments; ++segment)
+	{
+		unsigned char* memory = _segments[segment].load(std::memory_order_relaxed);
+		if (memory != nullptr)
+		{
+			_ByteTraits::deallocate(bytes, memory, _segmentBytes(segment));
+			_segments[segment].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+}
+
+VLCONCURRENT_TEMPLATE
+std::size_t VLCONCURRENT_CLASS::size() const
+{
+	std::size_t published = _published.load(std::memory_order_acquire);
+	std::size_t claimed = _claimed.load(std::memory_order_relaxed);
+	while (published < claimed && _ready(published))
+	{
+		++published;
+	}
+	// Share the scan with the other consumers, the prefix only grows.
+	std::size_t known = _published.load(std::memory_order_relaxed);
+	while (known < published && !_published.compare_exchange_weak(known, published,
+			std::memory_order_release, std::memory_order_relaxed)) {}
+	return published;
+}
+
+VLCONCURRENT_TEMPLATE
+void VLCONCURRENT_CLASS::reserve(std::size_t newCapacity)
+{
+	if (newCapacity > max_size())
+	{
+		throw std::length_error(LENGTH_ERR_MSG);
+	}
+	for (std::size_t segment = 0; _Layout::capacity(segment) < newCapacity; ++segment)
+	{
+		_segment(segment);
+	}
+}
+
+VLCONCURRENT_TEMPLATE
+template<class... Args>
+std::size_t VLCONCURRENT_CLASS::emplace_back(Args&&... args)
+{
+	if constexpr (std::is_nothrow_constructible<T, Args&&...>::value)
+	{
+		std::size_t index = _claim(1);
+		_fill(index, std::forward<Args>(args)...);
+		return index;
+	}
+	else
+	{
+		// A throw after claiming would leave a hole the prefix never passes.
+		T value(std::forward<Args>(args)...);
+		std::size_t index = _claim(1);
+		_fill(index, std::move(value));
+		return index;
+	}
+}
+
+VLCONCURRENT_TEMPLATE
+const T& VLCONCURRENT_CLASS::at(std::size_t index) const
+{
+	if (index >= size())
+	{
+		throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
+	}
+	return (*this)[index];
+}
+
+VLCONCURRENT_TEMPLATE
+T& VLCONCURRENT_CLASS::at(std::size_t index)
+{
+	if (index >= size())
+	{
+		throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
+	}
+	return (*this)[index];
+}
+
+VLCONCURRENT_TEMPLATE
+void VLCONCURRENT_CLASS::clear() noexcept
+{
+	std::size_t claimed = _claimed.load(std::memory_order_relaxed);
+	for (std::size_t index = 0; index < claimed; ++index)
+	{
+		std::pair<std::size_t, std::size_t> slot = _Layout::locate(index);
+		unsigned char* memory = _segments[slot.first].load(std::memory_order_relaxed);
+		// Slots whose segment allocation threw were claimed but never filled.
+		if (memory != nullptr && _flags(memory, slot.first)[slot.second].load(
+				std::memory_order_relaxed))
+		{
+			_AllocTraits::destroy(_alloc(), reinterpret_cast<T*>(memory) + slot.second);
+			_flags(memory, slot.first)[slot.second].store(false, std::memory_order_relaxed);
+		}
+	}
+	_claimed.store(0, std::memory_order_relaxed);
+	_published.store(0, std::memory_order_relaxed);
+}
+
+#undef VLCONCURRENT_CLASS
+#undef VLCONCURRENT_TEMPLATE
+
+#endif // VLCONCURRENT_VECTOR_HPP
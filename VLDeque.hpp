@@ -0,0 +1,890 @@
+/**
+ * @author Eli Fivelzon, eli.fivelzon@mail.huji.ac.il
+ * VLDeque<T, StaticCapacity>: a ring buffer with VLVector's inline first, heap when it outgrows
+ * StaticCapacity storage, so it can be used as a small FIFO: pushing and popping at either end
+ * is O(1) instead of shifting every element.
+ */
+#ifndef VLDEQUE_HPP
+#define VLDEQUE_HPP
+#include "VLVector.hpp"
+#include <initializer_list>
+
+namespace vl_detail
+{
+/**
+ * @class DequeIterator: Random access iterator over a VLDeque, an index into the container.
+ * @tparam T: The element, const for a const iterator.
+ * @tparam Deque: The container, const for a const iterator.
+ */
+template<class T, class Deque>
+class DequeIterator
+{
+private:
+	Deque* _deque;
+	std::ptrdiff_t _index;
+public:
+	typedef std::random_access_iterator_tag iterator_category;
+	typedef typename std::remove_const<T>::type value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef T* pointer;
+	typedef T& reference;
+
+	DequeIterator(): _deque(nullptr), _index(0) {}
+
+	/**
+	 * @param deque
+	 * @param index: The element pointed to.
+	 */
+	DequeIterator(Deque* deque, std::ptrdiff_t index): _deque(deque), _index(index) {}
+
+	/**
+	 * Iterator to const iterator conversion.
+	 */
+	template<class U, class Other, typename std::enable_if<
+			std::is_const<T>::value && !std::is_const<U>::value, int>::type = 0>
+	DequeIterator(const DequeIterator<U, Other> &other):
+			_deque(other.deque()), _index(other.index()) {}
+
+	Deque* deque() const { return _deque; }
+
+	/**
+	 * @return The index of the element pointed to.
+	 */
+	std::ptrdiff_t index() const { return _index; }
+
+	reference operator*() const { return (*_deque)[_index]; }
+
+	pointer operator->() const { return &(*_deque)[_index]; }
+
+	reference operator[](difference_type n) const { return (*_deque)[_index + n]; }
+
+	DequeIterator& operator++()
+	{
+		++_index;
+		return *this;
+	}
+
+	DequeIterator operator++(int)
+	{
+		DequeIterator old = *this;
+		++_index;
+		return old;
+	}
+
+	DequeIterator& operator--()
+	{
+		--_index;
+		return *this;
+	}
+
+	DequeIterator operator--(int)
+	{
+		DequeIterator old = *this;
+		--_index;
+		return old;
+	}
+
+	DequeIterator& operator+=(difference_type n)
+	{
+		_index += n;
+		return *this;
+	}
+
+	DequeIterator& operator-=(difference_type n)
+	{
+		_index -= n;
+		return *this;
+	}
+
+	DequeIterator operator+(difference_type n) const { return DequeIterator(_deque, _index + n); }
+
+	friend DequeIterator operator+(difference_type n, const DequeIterator &it) { return it + n; }
+
+	DequeIterator operator-(difference_type n) const { return DequeIterator(_deque, _index - n); }
+
+	difference_type operator-(const DequeIterator &other) const { return _index - other._index; }
+
+	bool operator==(const DequeIterator &other) const { return _index == other._index; }
+
+	bool operator!=(const DequeIterator &other) const { return _index != other._index; }
+
+	bool operator<(const DequeIterator &other) const { return _index < other._index; }
+
+	bool operator>(const DequeIterator &other) const { return _index > other._index; }
+
+	bool operator<=(const DequeIterator &other) const { return _index <= other._index; }
+
+	bool operator>=(const DequeIterator &other) const { return _index >= other._index; }
+};
+}
+
+/**
+ * @class VLDeque: Double ended queue in a ring buffer of capacity() elements, the inline
+ * memory while they fit in StaticCapacity and a heap memory otherwise. The elements start at a
+ * head index and wrap around the end of the memory. Growing unwraps them into the new memory
+ * with at most two contiguous relocations, capacities follow the rule of VLVector
+ * (vl_detail::growCapacity) and DemotionPolicy decides when popping and erasing move back
+ * inline. Inserting or erasing in the middle shifts the shorter side.
+ * @tparam T
+ * @tparam StaticCapacity
+ * @tparam GrowthPolicy
+ * @tparam Allocator
+ * @tparam DemotionPolicy
+ */
+template<class T, std::size_t StaticCapacity = DEFAULT_STATIC_CAPACITY,
+		 class GrowthPolicy = VLRatioGrowth<>, class Allocator = std::allocator<T>,
+		 class DemotionPolicy = VLDemoteAtCapacity>
+class VLDeque: private vl_detail::AllocatorHolder<Allocator>
+{
+	static_assert(std::is_same<typename Allocator::value_type, T>::value,
+				  "Allocator::value_type must be T.");
+	static_assert(alignof(T) <= vl_detail::AllocatorAlignment<Allocator>::value,
+				  "Allocator can't align T.");
+public:
+	typedef T value_type;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef Allocator allocator_type;
+	typedef vl_detail::DequeIterator<T, VLDeque> iterator;
+	typedef vl_detail::DequeIterator<const T, const VLDeque> const_iterator;
+private:
+	typedef std::allocator_traits<Allocator> _AllocTraits;
+
+	/**
+	 * Relocations of T may be done with memcpy.
+	 */
+	static constexpr bool _bitwiseRelocate = VLIsTriviallyRelocatable<T>::value
+			&& vl_detail::UsesDefaultConstruct<Allocator, T>::value;
+
+	alignas(T) unsigned char _staticMem[StaticCapacity > 0? StaticCapacity * sizeof(T): 1];
+	T* _mem;
+	std::size_t _head, _size, _capacity;
+
+	/**
+	 * Set by reserve() so popping won't move back inline, cleared by shrink_to_fit().
+	 */
+	bool _pinned;
+
+	Allocator& _alloc() { return this->allocator(); }
+
+	const Allocator& _alloc() const { return this->allocator(); }
+
+	T* _staticData() { return reinterpret_cast<T*>(_staticMem); }
+
+	bool _onHeap() const { return _capacity > StaticCapacity; }
+
+	/**
+	 * @param index
+	 * @return The slot of element index.
+	 */
+	T* _slot(std::size_t index) const
+	{
+		std::size_t slot = _head + index;
+		return _mem + (slot < _capacity? slot: slot - _capacity);
+	}
+
+	/**
+	 * @param capacity
+	 * @return The inline memory if capacity is at most StaticCapacity, otherwise a heap memory.
+	 */
+	T* _allocate(std::size_t capacity)
+	{
+		if (capacity <= StaticCapacity)
+		{
+			return _staticData();
+		}
+		return _AllocTraits::allocate(_alloc(), capacity);
+	}
+
+	/**
+	 * Free a memory returned by _allocate.
+	 */
+	void _deallocate(T* mem, std::size_t capacity) noexcept
+	{
+		if (capacity > StaticCapacity)
+		{
+			_AllocTraits::deallocate(_alloc(), mem, capacity);
+		}
+	}
+
+	/**
+	 * Destroy the elements [first, last).
+	 */
+	void _destroy(std::size_t first, std::size_t last) noexcept
+	{
+		for (std::size_t index = first; index < last; ++index)
+		{
+			_AllocTraits::destroy(_alloc(), _slot(index));
+		}
+	}
+
+	/**
+	 * Relocate count elements from first to the uninitialized dest, bitwise if T is trivially
+	 * relocatable, otherwise by move constructions (copies if the move may throw). If one
+	 * throws, the constructed ones are destroyed.
+	 */
+	void _relocate(T* first, std::size_t count, T* dest);
+
+	/**
+	 * Destroy count relocated elements (the originals, or the copies after a failure), nothing
+	 * to do if they were relocated bitwise.
+	 */
+	void _endRelocation(T* first, std::size_t count) noexcept;
+
+	/**
+	 * Move the elements to a memory of newCapacity (the inline memory if it is at most
+	 * StaticCapacity), unwrapped to start at offset. construct(mem) may build one more element
+	 * there first, so it can refer to the old ones, and returns its slot (or nullptr).
+	 * Strong exception guarantee.
+	 * @param newCapacity: At least size() + offset (plus one if construct builds).
+	 * @param offset
+	 * @param construct
+	 */
+	template<class Construct>
+	void _moveTo(std::size_t newCapacity, std::size_t offset, Construct construct);
+
+	/**
+	 * @return A construct for _moveTo which builds nothing.
+	 */
+	static auto _noConstruct()
+	{
+		return [](T*) -> T* { return nullptr; };
+	}
+
+	/**
+	 * Move back inline if DemotionPolicy says so after the size went down.
+	 */
+	void _demote()
+	{
+		if (_onHeap() && !_pinned && DemotionPolicy::onErase(_size, StaticCapacity))
+		{
+			_moveTo(StaticCapacity, 0, _noConstruct());
+		}
+	}
+
+	/**
+	 * Point at the empty inline memory, after the heap memory was taken or freed.
+	 */
+	void _resetInline() noexcept
+	{
+		_mem = _staticData();
+		_head = 0;
+		_size = 0;
+		_capacity = StaticCapacity;
+		_pinned = false;
+	}
+
+	/**
+	 * Take the elements of other, stealing its heap memory when steal is set and it has one.
+	 * The deque must be empty and inline, and other is left empty.
+	 */
+	void _takeElements(VLDeque &other, bool steal);
+
+	/**
+	 * Append copies of [first, last), the deque having room for them.
+	 */
+	template<class InputIterator>
+	void _appendCopies(InputIterator first, InputIterator last);
+public:
+	VLDeque(): VLDeque(Allocator()) {}
+
+	/**
+	 * @param alloc: The allocator of the heap memory.
+	 */
+	explicit VLDeque(const Allocator &alloc):
+			vl_detail::AllocatorHolder<Allocator>(alloc), _mem(_staticData()), _head(0), _size(0),
+			_capacity(StaticCapacity), _pinned(false) {}
+
+	/**
+	 * Copy constructor.
+	 * @param other
+	 */
+	VLDeque(const VLDeque &other);
+
+	/**
+	 * Move constructor, steals the heap memory of other.
+	 * @param other
+	 */
+	VLDeque(VLDeque &&other) noexcept(VLIsTriviallyRelocatable<T>::value
+									  || std::is_nothrow_move_constructible<T>::value);
+
+	/**
+	 * @param values
+	 * @param alloc
+	 */
+	VLDeque(std::initializer_list<T> values, const Allocator &alloc = Allocator());
+
+	~VLDeque()
+	{
+		_destroy(0, _size);
+		_deallocate(_mem, _capacity);
+	}
+
+	VLDeque& operator=(const VLDeque &other);
+
+	VLDeque& operator=(VLDeque &&other);
+
+	std::size_t size() const { return _size; }
+
+	bool empty() const { return _size == 0; }
+
+	/**
+	 * @return The num of elements the current memory holds.
+	 */
+	std::size_t capacity() const { return _capacity; }
+
+	std::size_t max_size() const
+	{
+		return std::min<std::size_t>(_AllocTraits::max_size(_alloc()), PTRDIFF_MAX / sizeof(T));
+	}
+
+	Allocator get_allocator() const { return _alloc(); }
+
+	/**
+	 * Make room for newCapacity elements. A heap memory allocated so is kept until
+	 * shrink_to_fit(), a reserve which doesn't allocate changes nothing.
+	 * @param newCapacity
+	 */
+	void reserve(std::size_t newCapacity);
+
+	/**
+	 * Fit the memory to size(), moving back inline if DemotionPolicy allows it.
+	 */
+	void shrink_to_fit();
+
+	/**
+	 * Erase all the elements.
+	 */
+	void clear()
+	{
+		_destroy(0, _size);
+		_head = 0;
+		_size = 0;
+		_demote();
+	}
+
+	T& operator[](std::size_t index) { return *_slot(index); }
+
+	const T& operator[](std::size_t index) const { return *_slot(index); }
+
+	/**
+	 * operator[] throwing std::out_of_range for an index past the end.
+	 */
+	T& at(std::size_t index)
+	{
+		if (index >= _size)
+		{
+			throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
+		}
+		return (*this)[index];
+	}
+
+	const T& at(std::size_t index) const
+	{
+		if (index >= _size)
+		{
+			throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
+		}
+		return (*this)[index];
+	}
+
+	T& front() { return *_slot(0); }
+
+	const T& front() const { return *_slot(0); }
+
+	T& back() { return *_slot(_size - 1); }
+
+	const T& back() const { return *_slot(_size - 1); }
+
+	/**
+	 * Append an element constructed from args.
+	 * @return The new element.
+	 */
+	template<class... Args>
+	T& emplace_back(Args&&... args);
+
+	/**
+	 * Prepend an element constructed from args.
+	 * @return The new element.
+	 */
+	template<class... Args>
+	T& emplace_front(Args&&... args);
+
+	void push_back(const T &value) { emplace_back(value); }
+
+	void push_back(T &&value) { emplace_back(std::move(value)); }
+
+	void push_front(const T &value) { emplace_front(value); }
+
+	void push_front(T &&value) { emplace_front(std::move(value)); }
+
+	/**
+	 * Erase the last element.
+	 */
+	void pop_back()
+	{
+		_AllocTraits::destroy(_alloc(), _slot(_size - 1));
+		--_size;
+		_demote();
+	}
+
+	/**
+	 * Erase the first element.
+	 */
+	void pop_front()
+	{
+		_AllocTraits::destroy(_alloc(), _slot(0));
+		_head = _head + 1 == _capacity? 0: _head + 1;
+		--_size;
+		_demote();
+	}
+
+	/**
+	 * Insert an element constructed from args before position, shifting the shorter side.
+	 * @param position
+	 * @param args
+	 * @return An iterator to the new element.
+	 */
+	template<class... Args>
+	iterator emplace(const_iterator position, Args&&... args);
+
+	iterator insert(const_iterator position, const T &value) { return emplace(position, value); }
+
+	iterator insert(const_iterator position, T &&value)
+	{
+		return emplace(position, std::move(value));
+	}
+
+	/**
+	 * @param position
+	 * @return An iterator to the element which followed the erased one.
+	 */
+	iterator erase(const_iterator position) { return erase(position, position + 1); }
+
+	/**
+	 * Erase [first, last), shifting the shorter side.
+	 * @param first
+	 * @param last
+	 * @return An iterator to the element which followed the erased ones.
+	 */
+	iterator erase(const_iterator first, const_iterator last);
+
+	/**
+	 * Swap the elements of the deques.
+	 * @param other
+	 */
+	void swap(VLDeque &other);
+
+	iterator begin() { return iterator(this, 0); }
+
+	const_iterator begin() const { return const_iterator(this, 0); }
+
+	const_iterator cbegin() const { return begin(); }
+
+	iterator end() { return iterator(this, _size); }
+
+	const_iterator end() const { return const_iterator(this, _size); }
+
+	const_iterator cend() const { return end(); }
+
+	bool operator==(const VLDeque &other) const
+	{
+		return _size == other._size && std::equal(begin(), end(), other.begin());
+	}
+
+	bool operator!=(const VLDeque &other) const { return !(*this == other); }
+};
+
+#define VLDEQUE_TEMPLATE template<class T, std::size_t StaticCapacity, class GrowthPolicy, \
+								  class Allocator, class DemotionPolicy>
+#define VLDEQUE_CLASS VLDeque<T, StaticCapacity, GrowthPolicy, Allocator, DemotionPolicy>
+
+VLDEQUE_TEMPLATE
+void VLDEQUE_CLASS::_relocate(T* first, std::size_t count, T* dest)
+{
+	if constexpr (_bitwiseRelocate)
+	{
+		if (count > 0)
+		{
+			std::memcpy(static_cast<void*>(dest), static_cast<const void*>(first),
+						count * sizeof(T));
+		}
+	}
+	else
+	{
+		std::size_t built = 0;
+		try
+		{
+			for (; built < count; ++built)
+			{
+				_AllocTraits::construct(_alloc(), dest + built,
+										std::move_if_noexcept(first[built]));
+			}
+		}
+		catch (...)
+		{
+			for (std::size_t index = 0; index < built; ++index)
+			{
+				_AllocTraits::destroy(_alloc(), dest + index);
+			}
+			throw;
+		}
+	}
+}
+
+VLDEQUE_TEMPLATE
+void VLDEQUE_CLASS::_endRelocation(T* first, std::size_t count) noexcept
+{
+	if constexpr (!_bitwiseRelocate)
+	{
+		for (std::size_t index = 0; index < count; ++index)
+		{
+			_AllocTraits::destroy(_alloc(), first + index);
+		}
+	}
+}
+
+VLDEQUE_TEMPLATE
+template<class Construct>
+void VLDEQUE_CLASS::_moveTo(std::size_t newCapacity, std::size_t offset, Construct construct)
+{
+	newCapacity = std::max(newCapacity, StaticCapacity);
+	T* mem = _allocate(newCapacity);
+	T* built = nullptr;
+	// The ring is [_head, _head + _size) wrapped around _capacity: at most two spans.
+	std::size_t firstCount = std::min(_size, _capacity - _head);
+	try
+	{
+		built = construct(mem);
+		_relocate(_mem + _head, firstCount, mem + offset);
+		try
+		{
+			_relocate(_mem, _size - firstCount, mem + offset + firstCount);
+		}
+		catch (...)
+		{
+			_endRelocation(mem + offset, firstCount);
+			throw;
+		}
+	}
+	catch (...)
+	{
+		if (built != nullptr)
+		{
+			_AllocTraits::destroy(_alloc(), built);
+		}
+		_deallocate(mem, newCapacity);
+		throw;
+	}
+	_endRelocation(_mem + _head, firstCount);
+	_endRelocation(_mem, _size - firstCount);
+	_deallocate(_mem, _capacity);
+	_mem = mem;
+	_head = 0;
+	_capacity = newCapacity;
+	_size += built != nullptr? 1: 0;
+	if (!_onHeap())
+	{
+		_pinned = false;
+	}
+}
+
+VLDEQUE_TEMPLATE
+void VLDEQUE_CLASS::_takeElements(VLDeque &other, bool steal)
+{
+	if (steal && other._onHeap())
+	{
+		_mem = other._mem;
+		_head = other._head;
+		_size = other._size;
+		_capacity = other._capacity;
+		_pinned = other._pinned;
+		other._resetInline();
+		return;
+	}
+	if (other._size > _capacity)
+	{
+		_moveTo(other._size, 0, _noConstruct());
+	}
+	std::size_t firstCount = std::min(other._size, other._capacity - other._head);
+	_relocate(other._mem + other._head, firstCount, _mem);
+	try
+	{
+		_relocate(other._mem, other._size - firstCount, _mem + firstCount);
+	}
+	catch (...)
+	{
+		_endRelocation(_mem, firstCount);
+		throw;
+	}
+	other._endRelocation(other._mem + other._head, firstCount);
+	other._endRelocation(other._mem, other._size - firstCount);
+	_size = other._size;
+	other._head = 0;
+	other._size = 0;
+}
+
+VLDEQUE_TEMPLATE
+template<class InputIterator>
+void VLDEQUE_CLASS::_appendCopies(InputIterator first, InputIterator last)
+{
+	for (; first != last; ++first)
+	{
+		_AllocTraits::construct(_alloc(), _slot(_size), *first);
+		++_size;
+	}
+}
+
+VLDEQUE_TEMPLATE
+VLDEQUE_CLASS::VLDeque(const VLDeque &other):
+		VLDeque(_AllocTraits::select_on_container_copy_construction(other._alloc()))
+{
+	reserve(other._size);
+	_pinned = false;
+	try
+	{
+		_appendCopies(other.begin(), other.end());
+	}
+	catch (...)
+	{
+		_destroy(0, _size);
+		_deallocate(_mem, _capacity);
+		throw;
+	}
+}
+
+VLDEQUE_TEMPLATE
+VLDEQUE_CLASS::VLDeque(VLDeque &&other) noexcept(VLIsTriviallyRelocatable<T>::value
+												 || std::is_nothrow_move_constructible<T>::value):
+		VLDeque(other._alloc())
+{
+	_takeElements(other, true);
+}
+
+VLDEQUE_TEMPLATE
+VLDEQUE_CLASS::VLDeque(std::initializer_list<T> values, const Allocator &alloc): VLDeque(alloc)
+{
+	reserve(values.size());
+	_pinned = false;
+	try
+	{
+		_appendCopies(values.begin(), values.end());
+	}
+	catch (...)
+	{
+		_destroy(0, _size);
+		_deallocate(_mem, _capacity);
+		throw;
+	}
+}
+
+VLDEQUE_TEMPLATE
+VLDEQUE_CLASS& VLDEQUE_CLASS::operator=(const VLDeque &other)
+{
+	if (&other == this)
+	{
+		return *this;
+	}
+	_destroy(0, _size);
+	_head = 0;
+	_size = 0;
+	if constexpr (_AllocTraits::propagate_on_container_copy_assignment::value)
+	{
+		if (!_AllocTraits::is_always_equal::value && _alloc() != other._alloc())
+		{
+			// The current memory belongs to the old allocator.
+			_deallocate(_mem, _capacity);
+			_resetInline();
+		}
+		_alloc() = other._alloc();
+	}
+	if (other._size > _capacity)
+	{
+		_moveTo(other._size, 0, _noConstruct());
+	}
+	_appendCopies(other.begin(), other.end());
+	return *this;
+}
+
+VLDEQUE_TEMPLATE
+VLDEQUE_CLASS& VLDEQUE_CLASS::operator=(VLDeque &&other)
+{
+	if (&other == this)
+	{
+		return *this;
+	}
+	_destroy(0, _size);
+	_deallocate(_mem, _capacity);
+	_resetInline();
+	bool steal = _AllocTraits::is_always_equal::value || _alloc() == other._alloc();
+	if constexpr (_AllocTraits::propagate_on_container_move_assignment::value)
+	{
+		_alloc() = other._alloc();
+		steal = true;
+	}
+	_takeElements(other, steal);
+	return *this;
+}
+
+VLDEQUE_TEMPLATE
+void VLDEQUE_CLASS::reserve(std::size_t newCapacity)
+{
+	if (newCapacity > max_size())
+	{
+		throw std::length_error(LENGTH_ERR_MSG);
+	}
+	if (newCapacity > _capacity)
+	{
+		_moveTo(newCapacity, 0, _noConstruct());
+		_pinned = true;
+	}
+}
+
+VLDEQUE_TEMPLATE
+void VLDEQUE_CLASS::shrink_to_fit()
+{
+	_pinned = false;
+	if (!_onHeap())
+	{
+		return;
+	}
+	// A heap memory must stay bigger than StaticCapacity to be told apart from the inline one.
+	bool toInline = DemotionPolicy::onShrink && _size <= StaticCapacity;
+	std::size_t newCapacity = toInline? StaticCapacity: std::max(_size, StaticCapacity + 1);
+	if (newCapacity < _capacity)
+	{
+		_moveTo(newCapacity, 0, _noConstruct());
+	}
+}
+
+VLDEQUE_TEMPLATE
+template<class... Args>
+T& VLDEQUE_CLASS::emplace_back(Args&&... args)
+{
+	if (_size == _capacity)
+	{
+		std::size_t newCapacity = vl_detail::growCapacity<GrowthPolicy>(_size, 1, StaticCapacity,
+																		 max_size(), sizeof(T));
+		_moveTo(newCapacity, 0, [&](T* mem)
+				{
+					_AllocTraits::construct(_alloc(), mem + _size, std::forward<Args>(args)...);
+					return mem + _size;
+				});
+	}
+	else
+	{
+		_AllocTraits::construct(_alloc(), _slot(_size), std::forward<Args>(args)...);
+		++_size;
+	}
+	return back();
+}
+
+VLDEQUE_TEMPLATE
+template<class... Args>
+T& VLDEQUE_CLASS::emplace_front(Args&&... args)
+{
+	if (_size == _capacity)
+	{
+		std::size_t newCapacity = vl_detail::growCapacity<GrowthPolicy>(_size, 1, StaticCapacity,
+																		 max_size(), sizeof(T));
+		_moveTo(newCapacity, 1, [&](T* mem)
+				{
+					_AllocTraits::construct(_alloc(), mem, std::forward<Args>(args)...);
+					return mem;
+				});
+	}
+	else
+	{
+		std::size_t head = _head == 0? _capacity - 1: _head - 1;
+		_AllocTraits::construct(_alloc(), _mem + head, std::forward<Args>(args)...);
+		_head = head;
+		++_size;
+	}
+	return front();
+}
+
+VLDEQUE_TEMPLATE
+template<class... Args>
+typename VLDEQUE_CLASS::iterator VLDEQUE_CLASS::emplace(const_iterator position, Args&&... args)
+{
+	std::size_t index = position.index();
+	if (index == _size)
+	{
+		emplace_back(std::forward<Args>(args)...);
+	}
+	else if (index == 0)
+	{
+		emplace_front(std::forward<Args>(args)...);
+	}
+	else if (index < _size / 2)
+	{
+		// args may refer to an element the shift moves.
+		T value(std::forward<Args>(args)...);
+		emplace_front(std::move(front()));
+		std::move(begin() + 2, begin() + index + 1, begin() + 1);
+		(*this)[index] = std::move(value);
+	}
+	else
+	{
+		T value(std::forward<Args>(args)...);
+		emplace_back(std::move(back()));
+		std::move_backward(begin() + index, end() - 2, end() - 1);
+		(*this)[index] = std::move(value);
+	}
+	return begin() + index;
+}
+
+VLDEQUE_TEMPLATE
+typename VLDEQUE_CLASS::iterator VLDEQUE_CLASS::erase(const_iterator first, const_iterator last)
+{
+	std::size_t index = first.index(), count = last - first;
+	if (count == 0)
+	{
+		return begin() + index;
+	}
+	if (index < _size - index - count)
+	{
+		std::move_backward(begin(), begin() + index, begin() + index + count);
+		_destroy(0, count);
+		_head = _head + count < _capacity? _head + count: _head + count - _capacity;
+	}
+	else
+	{
+		std::move(begin() + index + count, end(), begin() + index);
+		_destroy(_size - count, _size);
+	}
+	_size -= count;
+	_demote();
+	return begin() + index;
+}
+
+VLDEQUE_TEMPLATE
+void VLDEQUE_CLASS::swap(VLDeque &other)
+{
+	if (&other == this)
+	{
+		return;
+	}
+	// The moves carry the allocators along as far as they propagate on move assignment.
+	VLDeque elements(std::move(other));
+	other = std::move(*this);
+	*this = std::move(elements);
+}
+
+/**
+ * Swap the elements of the deques.
+ * @param first
+ * @param second
+ */
+VLDEQUE_TEMPLATE
+void swap(VLDEQUE_CLASS &first, VLDEQUE_CLASS &second)
+{
+	first.swap(second);
+}
+
+#undef VLDEQUE_CLASS
+#undef VLDEQUE_TEMPLATE
+
+#endif // VLDEQUE_HPP
@@ -0,0 +1,699 @@
+/**
+ * @author Eli Fivelzon, eli.fivelzon@mail.huji.ac.il
+ * VLFlatSet and VLFlatMap: sorted associative containers kept in a VLVector, so a small set or
+ * map lives entirely in the inline memory of its vector, a lookup is a binary search over
+ * contiguous elements instead of a walk over nodes, and only large ones spill to the heap.
+ */
+#ifndef VLFLAT_MAP_HPP
+#define VLFLAT_MAP_HPP
+#include "VLVector.hpp"
+#include <initializer_list>
+#include <tuple>
+
+/**
+ * Up to this size, inserting a range sorts the whole container by insertion, which needs no
+ * temporary buffer, instead of sorting the new elements and merging them in.
+ */
+#define VLFLAT_INSERTION_SORT_SIZE 32
+
+namespace vl_detail
+{
+/**
+ * @struct FlatSetKey: The key of an element of VLFlatSet, the element itself.
+ */
+struct FlatSetKey
+{
+	template<class Value>
+	const Value& operator()(const Value &value) const { return value; }
+};
+
+/**
+ * @struct FlatMapKey: The key of an element of VLFlatMap, its first.
+ */
+struct FlatMapKey
+{
+	template<class Key, class T>
+	const Key& operator()(const std::pair<Key, T> &value) const { return value.first; }
+};
+
+/**
+ * Binary search which moves its base with a conditional move instead of a branch, so random
+ * lookups don't pay for mispredictions. (A linear scan counting the smaller keys was no faster
+ * even at 8 elements, the compiler doesn't vectorize it at -O2.)
+ * @param first
+ * @param size
+ * @param before: True for the elements of a prefix of [first, first + size).
+ * @return The size of the prefix.
+ */
+template<class Value, class Predicate>
+std::size_t flatPartitionPoint(const Value* first, std::size_t size, Predicate before)
+{
+	if (size == 0)
+	{
+		return 0;
+	}
+	const Value* base = first;
+	while (size > 1)
+	{
+		std::size_t half = size / 2;
+		base = before(base[half])? base + half: base;
+		size -= half;
+	}
+	return (base - first) + (before(*base)? 1: 0);
+}
+
+/**
+ * Stable insertion sort.
+ * @param first
+ * @param last
+ * @param less
+ */
+template<class Value, class Less>
+void flatInsertionSort(Value* first, Value* last, Less less)
+{
+	for (Value* next = first + (first != last? 1: 0); next != last; ++next)
+	{
+		if (!less(*next, *(next - 1)))
+		{
+			continue;
+		}
+		Value value = std::move(*next);
+		Value* hole = next;
+		do
+		{
+			*hole = std::move(*(hole - 1));
+			--hole;
+		}
+		while (hole != first && less(value, *(hole - 1)));
+		*hole = std::move(value);
+	}
+}
+
+/**
+ * @class FlatMapIterator: Random access iterator over the elements of a VLFlatMap. They are
+ * stored as std::pair<Key, T>, but dereferencing gives a std::pair<const Key&, T&>, so the value
+ * can be assigned through it and the key, on which the order depends, can't. Converts to the
+ * const iterator, a plain const pointer.
+ * @tparam Key
+ * @tparam Value: std::pair<Key, T>.
+ */
+template<class Key, class Value>
+class FlatMapIterator
+{
+	typedef typename Value::second_type _Mapped;
+public:
+	typedef std::random_access_iterator_tag iterator_category;
+	typedef Value value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef std::pair<const Key&, _Mapped&> reference;
+
+	/**
+	 * @struct pointer: What operator-> returns, holds the reference it points to.
+	 */
+	struct pointer
+	{
+		reference element;
+
+		const reference* operator->() const { return &element; }
+	};
+private:
+	Value* _element;
+public:
+	FlatMapIterator(): _element(nullptr) {}
+
+	/**
+	 * @param element: The element pointed to.
+	 */
+	explicit FlatMapIterator(Value* element): _element(element) {}
+
+	/**
+	 * @return The element pointed to, as the const iterator.
+	 */
+	operator const Value*() const { return _element; }
+
+	reference operator*() const { return reference(_element->first, _element->second); }
+
+	pointer operator->() const { return pointer{**this}; }
+
+	reference operator[](difference_type n) const { return *(*this + n); }
+
+	FlatMapIterator& operator++()
+	{
+		++_element;
+		return *this;
+	}
+
+	FlatMapIterator operator++(int)
+	{
+		FlatMapIterator old = *this;
+		++_element;
+		return old;
+	}
+
+	FlatMapIterator& operator--()
+	{
+		--_element;
+		return *this;
+	}
+
+	FlatMapIterator operator--(int)
+	{
+		FlatMapIterator old = *this;
+		--_element;
+		return old;
+	}
+
+	FlatMapIterator& operator+=(difference_type n)
+	{
+		_element += n;
+		return *this;
+	}
+
+	FlatMapIterator& operator-=(difference_type n)
+	{
+		_element -= n;
+		return *this;
+	}
+
+	FlatMapIterator operator+(difference_type n) const { return FlatMapIterator(_element + n); }
+
+	friend FlatMapIterator operator+(difference_type n, const FlatMapIterator &it)
+	{
+		return it + n;
+	}
+
+	FlatMapIterator operator-(difference_type n) const { return FlatMapIterator(_element - n); }
+
+	difference_type operator-(const FlatMapIterator &other) const
+	{
+		return _element - other._element;
+	}
+
+	bool operator==(const FlatMapIterator &other) const { return _element == other._element; }
+
+	bool operator!=(const FlatMapIterator &other) const { return _element != other._element; }
+
+	bool operator<(const FlatMapIterator &other) const { return _element < other._element; }
+
+	bool operator>(const FlatMapIterator &other) const { return _element > other._element; }
+
+	bool operator<=(const FlatMapIterator &other) const { return _element <= other._element; }
+
+	bool operator>=(const FlatMapIterator &other) const { return _element >= other._element; }
+};
+
+/**
+ * @class FlatTree: What VLFlatSet and VLFlatMap share, elements sorted by key without
+ * duplicates in a VLVector. Inserting and erasing shift the following elements, which is
+ * cheap for the small sizes these containers are meant for.
+ * @tparam Key
+ * @tparam Value: The element, Key for a set.
+ * @tparam KeyOf: Gives the key of an element.
+ * @tparam StaticCapacity
+ * @tparam Compare
+ * @tparam Allocator
+ */
+template<class Key, class Value, class KeyOf, std::size_t StaticCapacity, class Compare,
+		 class Allocator>
+class FlatTree: private AllocatorHolder<Compare>
+{
+public:
+	typedef Key key_type;
+	typedef Value value_type;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef Compare key_compare;
+	typedef Allocator allocator_type;
+	typedef const Value& const_reference;
+
+	/**
+	 * Keys can't be changed in place, so a set only has const iterators and a map's give the
+	 * keys as const.
+	 */
+	typedef typename std::conditional<std::is_same<Key, Value>::value, const Value*,
+									  FlatMapIterator<Key, Value>>::type iterator;
+	typedef const Value* const_iterator;
+	typedef typename std::iterator_traits<iterator>::reference reference;
+protected:
+	typedef VLVector<Value, StaticCapacity, VLRatioGrowth<>, std::size_t, Allocator> _Values;
+
+	_Values _values;
+
+	/**
+	 * AllocatorHolder keeps a stateless comparator as an empty base, like an allocator.
+	 */
+	const Compare& _comp() const { return this->allocator(); }
+
+	/**
+	 * @param key
+	 * @return The index of the first element whose key is not less than key.
+	 */
+	std::size_t _lowerIndex(const Key &key) const
+	{
+		return flatPartitionPoint(_values.data(), _values.size(),
+								  [&](const Value &value) { return _comp()(KeyOf()(value), key); });
+	}
+
+	/**
+	 * @param key
+	 * @return The index of the first element whose key is greater than key.
+	 */
+	std::size_t _upperIndex(const Key &key) const
+	{
+		return flatPartitionPoint(_values.data(), _values.size(), [&](const Value &value)
+								  {
+									  return !_comp()(key, KeyOf()(value));
+								  });
+	}
+
+	/**
+	 * @param index
+	 * @param key
+	 * @return True if the element at index exists and has key.
+	 */
+	bool _matches(std::size_t index, const Key &key) const
+	{
+		return index < _values.size() && !_comp()(key, KeyOf()(_values[index]));
+	}
+
+	/**
+	 * @return The element order.
+	 */
+	bool _less(const Value &first, const Value &second) const
+	{
+		return _comp()(KeyOf()(first), KeyOf()(second));
+	}
+
+	iterator _at(std::size_t index) { return iterator(_values.begin() + index); }
+public:
+	/**
+	 * @param comp
+	 * @param alloc
+	 */
+	explicit FlatTree(const Compare &comp = Compare(), const Allocator &alloc = Allocator()):
+			AllocatorHolder<Compare>(comp), _values(alloc) {}
+
+	/**
+	 * @param first
+	 * @param last
+	 * @param comp
+	 * @param alloc
+	 */
+	template<class InputIterator, class = typename std::iterator_traits<
+			InputIterator>::iterator_category>
+	FlatTree(InputIterator first, InputIterator last, const Compare &comp = Compare(),
+			 const Allocator &alloc = Allocator()): FlatTree(comp, alloc)
+	{
+		insert(first, last);
+	}
+
+	/**
+	 * @param values
+	 * @param comp
+	 * @param alloc
+	 */
+	FlatTree(std::initializer_list<Value> values, const Compare &comp = Compare(),
+			 const Allocator &alloc = Allocator()): FlatTree(values.begin(), values.end(), comp,
+															 alloc) {}
+
+	std::size_t size() const { return _values.size(); }
+
+	bool empty() const { return _values.empty(); }
+
+	std::size_t max_size() const { return _values.max_size(); }
+
+	/**
+	 * @return The num of elements the current memory holds.
+	 */
+	std::size_t capacity() const { return _values.capacity(); }
+
+	void reserve(std::size_t newCapacity) { _values.reserve(newCapacity); }
+
+	void shrink_to_fit() { _values.shrink_to_fit(); }
+
+	void clear() { _values.clear(); }
+
+	Compare key_comp() const { return _comp(); }
+
+	Allocator get_allocator() const { return _values.get_allocator(); }
+
+	/**
+	 * @param key
+	 * @return The element with key, or end().
+	 */
+	iterator find(const Key &key)
+	{
+		std::size_t index = _lowerIndex(key);
+		return _matches(index, key)? _at(index): end();
+	}
+
+	const_iterator find(const Key &key) const
+	{
+		std::size_t index = _lowerIndex(key);
+		return _matches(index, key)? begin() + index: end();
+	}
+
+	std::size_t count(const Key &key) const { return _matches(_lowerIndex(key), key)? 1: 0; }
+
+	bool contains(const Key &key) const { return _matches(_lowerIndex(key), key); }
+
+	iterator lower_bound(const Key &key) { return _at(_lowerIndex(key)); }
+
+	const_iterator lower_bound(const Key &key) const { return begin() + _lowerIndex(key); }
+
+	iterator upper_bound(const Key &key) { return _at(_upperIndex(key)); }
+
+	const_iterator upper_bound(const Key &key) const { return begin() + _upperIndex(key); }
+
+	std::pair<iterator, iterator> equal_range(const Key &key)
+	{
+		std::size_t index = _lowerIndex(key);
+		return {_at(index), _at(index + (_matches(index, key)? 1: 0))};
+	}
+
+	std::pair<const_iterator, const_iterator> equal_range(const Key &key) const
+	{
+		std::size_t index = _lowerIndex(key);
+		return {begin() + index, begin() + index + (_matches(index, key)? 1: 0)};
+	}
+
+	/**
+	 * Insert value unless an element with its key exists.
+	 * @param value
+	 * @return The element with the key of value, and whether value was inserted.
+	 */
+	std::pair<iterator, bool> insert(const Value &value) { return _insert(value); }
+
+	std::pair<iterator, bool> insert(Value &&value) { return _insert(std::move(value)); }
+
+	/**
+	 * insert(value) which first tries just before hint.
+	 * @param hint
+	 * @param value
+	 * @return The element with the key of value.
+	 */
+	iterator insert(const_iterator hint, const Value &value) { return _insert(hint, value); }
+
+	iterator insert(const_iterator hint, Value &&value) { return _insert(hint, std::move(value)); }
+
+	/**
+	 * Insert the elements of [first, last) whose keys are not in the container yet (the first
+	 * of duplicates wins). They are appended at once, sorted and merged in, instead of being
+	 * inserted one by one. If a comparison or a move throws, the container is cleared.
+	 * @param first
+	 * @param last
+	 */
+	template<class InputIterator, class = typename std::iterator_traits<
+			InputIterator>::iterator_category>
+	void insert(InputIterator first, InputIterator last);
+
+	void insert(std::initializer_list<Value> values) { insert(values.begin(), values.end()); }
+
+	/**
+	 * insert(value) of a value constructed from args.
+	 */
+	template<class... Args>
+	std::pair<iterator, bool> emplace(Args&&... args)
+	{
+		return _insert(Value(std::forward<Args>(args)...));
+	}
+
+	/**
+	 * @param position
+	 * @return The element which followed the erased one.
+	 */
+	iterator erase(const_iterator position) { return iterator(_values.erase(position)); }
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		return iterator(_values.erase(first, last));
+	}
+
+	/**
+	 * @param key
+	 * @return The num of elements erased.
+	 */
+	std::size_t erase(const Key &key)
+	{
+		std::size_t index = _lowerIndex(key);
+		if (!_matches(index, key))
+		{
+			return 0;
+		}
+		_values.erase(_values.cbegin() + index);
+		return 1;
+	}
+
+	void swap(FlatTree &other)
+	{
+		using std::swap;
+		swap(this->allocator(), other.allocator());
+		_values.swap(other._values);
+	}
+
+	iterator begin() { return iterator(_values.begin()); }
+
+	const_iterator begin() const { return _values.begin(); }
+
+	const_iterator cbegin() const { return begin(); }
+
+	iterator end() { return iterator(_values.end()); }
+
+	const_iterator end() const { return _values.end(); }
+
+	const_iterator cend() const { return end(); }
+
+	bool operator==(const FlatTree &other) const { return _values == other._values; }
+
+	bool operator!=(const FlatTree &other) const { return _values != other._values; }
+private:
+	template<class V>
+	std::pair<iterator, bool> _insert(V &&value);
+
+	template<class V>
+	iterator _insert(const_iterator hint, V &&value);
+};
+
+#define VLFLAT_TREE_TEMPLATE template<class Key, class Value, class KeyOf, \
+									  std::size_t StaticCapacity, class Compare, class Allocator>
+#define VLFLAT_TREE_CLASS FlatTree<Key, Value, KeyOf, StaticCapacity, Compare, Allocator>
+
+VLFLAT_TREE_TEMPLATE
+template<class V>
+std::pair<typename VLFLAT_TREE_CLASS::iterator, bool> VLFLAT_TREE_CLASS::_insert(V &&value)
+{
+	std::size_t index = _lowerIndex(KeyOf()(value));
+	if (_matches(index, KeyOf()(value)))
+	{
+		return {_at(index), false};
+	}
+	return {iterator(_values.insert(_values.cbegin() + index, std::forward<V>(value))), true};
+}
+
+VLFLAT_TREE_TEMPLATE
+template<class V>
+typename VLFLAT_TREE_CLASS::iterator VLFLAT_TREE_CLASS::_insert(const_iterator hint, V &&value)
+{
+	const Key &key = KeyOf()(value);
+	if ((hint == cend() || _comp()(key, KeyOf()(*hint)))
+		&& (hint == cbegin() || _comp()(KeyOf()(*(hint - 1)), key)))
+	{
+		return iterator(_values.insert(hint, std::forward<V>(value)));
+	}
+	return _insert(std::forward<V>(value)).first;
+}
+
+VLFLAT_TREE_TEMPLATE
+template<class InputIterator, class>
+void VLFLAT_TREE_CLASS::insert(InputIterator first, InputIterator last)
+{
+	std::size_t oldSize = _values.size();
+	_values.insert(_values.cend(), first, last);
+	auto valueLess = [this](const Value &lhs, const Value &rhs) { return _less(lhs, rhs); };
+	Value* begin = _values.begin();
+	Value* middle = begin + oldSize;
+	Value* end = _values.end();
+	try
+	{
+		// Both sorts are stable, so the old elements and then the first new ones come first
+		// among equal keys and survive unique.
+		if (_values.size() <= VLFLAT_INSERTION_SORT_SIZE)
+		{
+			flatInsertionSort(begin, end, valueLess);
+		}
+		else
+		{
+			if (!std::is_sorted(middle, end, valueLess))
+			{
+				std::stable_sort(middle, end, valueLess);
+			}
+			if (middle != begin && middle != end && valueLess(*middle, *(middle - 1)))
+			{
+				std::inplace_merge(begin, middle, end, valueLess);
+			}
+		}
+		Value* unique = std::unique(begin, end, [&](const Value &lhs, const Value &rhs)
+									{
+										return !valueLess(lhs, rhs);
+									});
+		_values.erase(unique, end);
+	}
+	catch (...)
+	{
+		_values.clear();
+		throw;
+	}
+}
+
+#undef VLFLAT_TREE_CLASS
+#undef VLFLAT_TREE_TEMPLATE
+}
+
+/**
+ * @class VLFlatSet: Sorted set of keys in a VLVector of StaticCapacity inline elements.
+ * @tparam Key
+ * @tparam StaticCapacity
+ * @tparam Compare
+ * @tparam Allocator
+ */
+template<class Key, std::size_t StaticCapacity = DEFAULT_STATIC_CAPACITY,
+		 class Compare = std::less<Key>, class Allocator = std::allocator<Key>>
+class VLFlatSet: public vl_detail::FlatTree<Key, Key, vl_detail::FlatSetKey, StaticCapacity,
+											Compare, Allocator>
+{
+	typedef vl_detail::FlatTree<Key, Key, vl_detail::FlatSetKey, StaticCapacity, Compare,
+								Allocator> _Base;
+public:
+	using _Base::_Base;
+
+	VLFlatSet() = default;
+};
+
+/**
+ * @class VLFlatMap: Sorted map in a VLVector of StaticCapacity inline std::pair<Key, T>. Its
+ * iterators give std::pair<const Key&, T&> (see FlatMapIterator). Unlike std::map, inserting or
+ * erasing invalidates the iterators and references to the elements which follow.
+ * @tparam Key
+ * @tparam T
+ * @tparam StaticCapacity
+ * @tparam Compare
+ * @tparam Allocator
+ */
+template<class Key, class T, std::size_t StaticCapacity = DEFAULT_STATIC_CAPACITY,
+		 class Compare = std::less<Key>, class Allocator = std::allocator<std::pair<Key, T>>>
+class VLFlatMap: public vl_detail::FlatTree<Key, std::pair<Key, T>, vl_detail::FlatMapKey,
+											StaticCapacity, Compare, Allocator>
+{
+	typedef vl_detail::FlatTree<Key, std::pair<Key, T>, vl_detail::FlatMapKey, StaticCapacity,
+								Compare, Allocator> _Base;
+
+	/**
+	 * @return The element with key, appended from key and args if there is none.
+	 */
+	template<class K, class... Args>
+	std::pair<typename _Base::iterator, bool> _tryEmplace(K &&key, Args&&... args)
+	{
+		std::size_t index = this->_lowerIndex(key);
+		if (this->_matches(index, key))
+		{
+			return {this->_at(index), false};
+		}
+		return {typename _Base::iterator(this->_values.emplace(this->_values.cbegin() + index,
+				std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+				std::forward_as_tuple(std::forward<Args>(args)...))), true};
+	}
+public:
+	typedef T mapped_type;
+
+	using _Base::_Base;
+
+	VLFlatMap() = default;
+
+	/**
+	 * @param key
+	 * @return The value of key, value initialized first if key is missing.
+	 */
+	T& operator[](const Key &key) { return _tryEmplace(key).first->second; }
+
+	T& operator[](Key &&key) { return _tryEmplace(std::move(key)).first->second; }
+
+	/**
+	 * @param key
+	 * @return The value of key, throws std::out_of_range if it is missing.
+	 */
+	T& at(const Key &key)
+	{
+		typename _Base::iterator it = this->find(key);
+		if (it == this->end())
+		{
+			throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
+		}
+		return it->second;
+	}
+
+	const T& at(const Key &key) const
+	{
+		typename _Base::const_iterator it = this->find(key);
+		if (it == this->end())
+		{
+			throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
+		}
+		return it->second;
+	}
+
+	/**
+	 * Insert a value constructed from args for key, unless key exists (then args are unused).
+	 * @param key
+	 * @param args
+	 * @return The element with key, and whether it was inserted.
+	 */
+	template<class... Args>
+	std::pair<typename _Base::iterator, bool> try_emplace(const Key &key, Args&&... args)
+	{
+		return _tryEmplace(key, std::forward<Args>(args)...);
+	}
+
+	template<class... Args>
+	std::pair<typename _Base::iterator, bool> try_emplace(Key &&key, Args&&... args)
+	{
+		return _tryEmplace(std::move(key), std::forward<Args>(args)...);
+	}
+
+	/**
+	 * @param key
+	 * @param value: Assigned to the value of key, or inserted with key if it is missing.
+	 * @return The element with key, and whether it was inserted.
+	 */
+	template<class M>
+	std::pair<typename _Base::iterator, bool> insert_or_assign(const Key &key, M &&value)
+	{
+		std::pair<typename _Base::iterator, bool> result = _tryEmplace(key, std::forward<M>(value));
+		if (!result.second)
+		{
+			result.first->second = std::forward<M>(value);
+		}
+		return result;
+	}
+};
+
+/**
+ * Swap the elements of the sets.
+ */
+template<class Key, std::size_t StaticCapacity, class Compare, class Allocator>
+void swap(VLFlatSet<Key, StaticCapacity, Compare, Allocator> &first,
+		  VLFlatSet<Key, StaticCapacity, Compare, Allocator> &second)
+{
+	first.swap(second);
+}
+
+/**
+ * Swap the elements of the maps.
+ */
+template<class Key, class T, std::size_t StaticCapacity, class Compare, class Allocator>
+void swap(VLFlatMap<Key, T, StaticCapacity, Compare, Allocator> &first,
+		  VLFlatMap<Key, T, StaticCapacity, Compare, Allocator> &second)
+{
+	first.swap(second);
+}
+
+#endif // VLFLAT_MAP_HPP
@@ -0,0 +1,329 @@
+/**
+ * @author Eli Fivelzon, eli.fivelzon@mail.huji.ac.il
+ * Heap memories for multi GB vectors. VLHugePageAllocator serves blocks from
+ * VLHUGE_PAGE_THRESHOLD bytes up with mmap, aligned to and advised for 2 MiB transparent huge
+ * pages so scans don't miss the TLB every 4 KiB, grows them with mremap instead of copying and
+ * splits the bulk copies VLVector does on copy construction and range insert across threads,
+ * e.g. VLVector<double, 16, VLRatioGrowth<>, std::size_t, VLHugePageAllocator<double>>.
+ * Smaller blocks come from operator new as usual.
+ */
+#ifndef VLHUGE_PAGE_ALLOCATOR_HPP
+#define VLHUGE_PAGE_ALLOCATOR_HPP
+#include "VLVector.hpp"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#define VLHUGE_PAGE_HAS_MMAP
+#endif
+
+/**
+ * The transparent huge page size mapped blocks are aligned to and rounded up to.
+ */
+#define VLHUGE_PAGE_SIZE (std::size_t(2) << 20)
+
+/**
+ * Blocks of at least this many bytes are mapped, smaller ones come from operator new.
+ */
+#define VLHUGE_PAGE_THRESHOLD VLHUGE_PAGE_SIZE
+
+/**
+ * Copies of at least this many bytes are split across threads, below it a thread's start
+ * costs more than it saves.
+ */
+#define VLPARALLEL_COPY_THRESHOLD (std::size_t(16) << 20)
+
+/**
+ * The least bytes a copy thread gets.
+ */
+#define VLPARALLEL_COPY_MIN_CHUNK (std::size_t(4) << 20)
+
+/**
+ * @class VLHugePages: The mapping and copying behind VLHugePageAllocator.
+ */
+class VLHugePages
+{
+private:
+	static std::atomic<unsigned>& _copyThreads()
+	{
+		static std::atomic<unsigned> threads(0);
+		return threads;
+	}
+
+	/**
+	 * @param bytes: At least VLHUGE_PAGE_THRESHOLD.
+	 * @return The length of the mapping of a block of bytes.
+	 */
+	static std::size_t _mappedBytes(std::size_t bytes)
+	{
+		if (bytes > std::size_t(-1) - VLHUGE_PAGE_SIZE)
+		{
+			throw std::bad_alloc();
+		}
+		return (bytes + VLHUGE_PAGE_SIZE - 1) / VLHUGE_PAGE_SIZE * VLHUGE_PAGE_SIZE;
+	}
+
+	/**
+	 * Advise the kernel to back length bytes from first with huge pages.
+	 */
+	static void _advise(void* first, std::size_t length) noexcept;
+
+	static void* _map(std::size_t bytes);
+
+	static void _unmap(void* block, std::size_t bytes) noexcept;
+public:
+	/**
+	 * @param bytes
+	 * @return Whether a block of bytes is mapped.
+	 */
+	static bool mapped(std::size_t bytes)
+	{
+#ifdef VLHUGE_PAGE_HAS_MMAP
+		return bytes >= VLHUGE_PAGE_THRESHOLD;
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * @param bytes
+	 * @return A block of at least bytes, throws std::bad_alloc on failure.
+	 */
+	static void* allocate(std::size_t bytes)
+	{
+		return mapped(bytes)? _map(bytes): ::operator new(bytes);
+	}
+
+	/**
+	 * @param block: Returned by allocate or reallocate.
+	 * @param bytes: The size block was allocated with.
+	 */
+	static void deallocate(void* block, std::size_t bytes) noexcept
+	{
+		if (mapped(bytes))
+		{
+			_unmap(block, bytes);
+		}
+		else
+		{
+			::operator delete(block);
+		}
+	}
+
+	/**
+	 * Resize a block, remapping its pages when both sizes are mapped.
+	 * @param block
+	 * @param bytes: The size block was allocated with.
+	 * @param newBytes
+	 * @return The (possibly moved) block holding the first min(bytes, newBytes) bytes, aligned
+	 * like the ones allocate maps, or throws std::bad_alloc leaving block untouched.
+	 */
+	static void* reallocate(void* block, std::size_t bytes, std::size_t newBytes);
+
+	/**
+	 * memcpy, split across copyThreads() threads from VLPARALLEL_COPY_THRESHOLD bytes up.
+	 * @param dest: Must not overlap [src, src + bytes).
+	 * @param src
+	 * @param bytes
+	 */
+	static void copy(void* dest, const void* src, std::size_t bytes);
+
+	/**
+	 * @return The num of threads of a parallel copy, the hardware's by default.
+	 */
+	static unsigned copyThreads()
+	{
+		unsigned threads = _copyThreads().load(std::memory_order_relaxed);
+		return threads != 0? threads: std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	/**
+	 * @param threads: 1 copies on the calling thread only, 0 restores the default.
+	 */
+	static void setCopyThreads(unsigned threads)
+	{
+		_copyThreads().store(threads, std::memory_order_relaxed);
+	}
+};
+
+inline void VLHugePages::_advise(void* first, std::size_t length) noexcept
+{
+#if defined(VLHUGE_PAGE_HAS_MMAP) && defined(MADV_HUGEPAGE)
+	// Only advice, the kernel may have transparent huge pages off.
+	madvise(first, length, MADV_HUGEPAGE);
+#else
+	(void)first;
+	(void)length;
+#endif
+}
+
+inline void* VLHugePages::_map(std::size_t bytes)
+{
+#ifdef VLHUGE_PAGE_HAS_MMAP
+	std::size_t length = _mappedBytes(bytes);
+	if (length > std::size_t(-1) - VLHUGE_PAGE_SIZE)
+	{
+		throw std::bad_alloc();
+	}
+	// mmap only aligns to 4 KiB, so map a huge page more and trim to the 2 MiB boundary.
+	void* mem = mmap(nullptr, length + VLHUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+					 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED)
+	{
+		throw std::bad_alloc();
+	}
+	unsigned char* first = static_cast<unsigned char*>(mem);
+	std::size_t head = (VLHUGE_PAGE_SIZE - reinterpret_cast<std::uintptr_t>(first)
+						% VLHUGE_PAGE_SIZE) % VLHUGE_PAGE_SIZE;
+	if (head > 0)
+	{
+		munmap(first, head);
+	}
+	munmap(first + head + length, VLHUGE_PAGE_SIZE - head);
+	_advise(first + head, length);
+	return first + head;
+#else
+	return ::operator new(bytes);
+#endif
+}
+
+inline void VLHugePages::_unmap(void* block, std::size_t bytes) noexcept
+{
+#ifdef VLHUGE_PAGE_HAS_MMAP
+	munmap(block, _mappedBytes(bytes));
+#else
+	::operator delete(block);
+#endif
+}
+
+inline void* VLHugePages::reallocate(void* block, std::size_t bytes, std::size_t newBytes)
+{
+#if defined(VLHUGE_PAGE_HAS_MMAP) && defined(MREMAP_MAYMOVE) && defined(MREMAP_FIXED)
+	if (block != nullptr && mapped(bytes) && mapped(newBytes))
+	{
+		std::size_t length = _mappedBytes(bytes), newLength = _mappedBytes(newBytes);
+		void* mem = mremap(block, length, newLength, 0);
+		if (mem == MAP_FAILED)
+		{
+			// A moving mremap picks a 4 KiB aligned address, so move the pages over an aligned
+			// mapping instead, which the kernel replaces.
+			void* target = _map(newBytes);
+			mem = mremap(block, length, newLength, MREMAP_MAYMOVE | MREMAP_FIXED, target);
+			if (mem == MAP_FAILED)
+			{
+				_unmap(target, newBytes);
+				throw std::bad_alloc();
+			}
+		}
+		_advise(mem, newLength);
+		return mem;
+	}
+#endif
+	void* mem = allocate(newBytes);
+	if (block != nullptr)
+	{
+		copy(mem, block, std::min(bytes, newBytes));
+		deallocate(block, bytes);
+	}
+	return mem;
+}
+
+inline void VLHugePages::copy(void* dest, const void* src, std::size_t bytes)
+{
+	std::size_t chunks = std::min<std::size_t>(copyThreads(), bytes / VLPARALLEL_COPY_MIN_CHUNK);
+	if (bytes < VLPARALLEL_COPY_THRESHOLD || chunks <= 1)
+	{
+		if (bytes > 0)
+		{
+			std::memcpy(dest, src, bytes);
+		}
+		return;
+	}
+	// Chunks of whole pages, so no two threads write the same page.
+	std::size_t chunk = (bytes / chunks + 4095) / 4096 * 4096;
+	unsigned char* out = static_cast<unsigned char*>(dest);
+	const unsigned char* in = static_cast<const unsigned char*>(src);
+	std::vector<std::thread> threads;
+	std::size_t offset = 0;
+	try
+	{
+		threads.reserve(chunks - 1);
+		for (; bytes - offset > chunk; offset += chunk)
+		{
+			threads.emplace_back([out, in, offset, chunk]
+			{
+				std::memcpy(out + offset, in + offset, chunk);
+			});
+		}
+	}
+	catch (...)
+	{
+		// The chunks of the threads which couldn't start are left to the calling thread.
+	}
+	std::memcpy(out + offset, in + offset, bytes - offset);
+	for (std::thread &thread: threads)
+	{
+		thread.join();
+	}
+}
+
+/**
+ * @struct VLHugePageAllocator: Allocator taking its blocks from VLHugePages. Its reallocate
+ * lets VLVector grow trivially relocatable elements by remapping, and its copy_bytes splits
+ * VLVector's other bulk copies across threads.
+ * @tparam T
+ */
+template<class T>
+struct VLHugePageAllocator
+{
+	static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "operator new can't align T.");
+
+	typedef T value_type;
+	typedef std::true_type is_always_equal;
+
+	static constexpr std::size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+	VLHugePageAllocator() = default;
+
+	template<class U>
+	VLHugePageAllocator(const VLHugePageAllocator<U>&) noexcept {}
+
+	T* allocate(std::size_t capacity)
+	{
+		if (capacity > std::size_t(-1) / sizeof(T))
+		{
+			throw std::bad_alloc();
+		}
+		return static_cast<T*>(VLHugePages::allocate(capacity * sizeof(T)));
+	}
+
+	void deallocate(T* mem, std::size_t capacity) noexcept
+	{
+		VLHugePages::deallocate(mem, capacity * sizeof(T));
+	}
+
+	T* reallocate(T* mem, std::size_t capacity, std::size_t newCapacity)
+	{
+		if (newCapacity > std::size_t(-1) / sizeof(T))
+		{
+			throw std::bad_alloc();
+		}
+		return static_cast<T*>(VLHugePages::reallocate(mem, capacity * sizeof(T),
+													   newCapacity * sizeof(T)));
+	}
+
+	static void copy_bytes(void* dest, const void* src, std::size_t bytes)
+	{
+		VLHugePages::copy(dest, src, bytes);
+	}
+
+	template<class U>
+	bool operator==(const VLHugePageAllocator<U>&) const noexcept { return true; }
+
+	template<class U>
+	bool operator!=(const VLHugePageAllocator<U>&) const noexcept { return false; }
+};
+
+#endif // VLHUGE_PAGE_ALLOCATOR_HPP
@@ -0,0 +1,224 @@
+/**
+ * @author Eli Fivelzon, eli.fivelzon@mail.huji.ac.il
+ * Thread local recycling of heap memories. VLPoolAllocator keeps freed blocks in a free list
+ * per allocation size class (see VLSizeClassGrowth) and hands them out again to the next
+ * allocation of the same class on the same thread, so vectors which spill to the heap and
+ * demote back over and over don't go through the global allocator each time, e.g.
+ * VLVector<Record, 8, VLSizeClassGrowth<>, std::size_t, VLPoolAllocator<Record>>.
+ */
+#ifndef VLPOOL_ALLOCATOR_HPP
+#define VLPOOL_ALLOCATOR_HPP
+#include "VLVector.hpp"
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+/**
+ * Default bound on the bytes a thread keeps cached, see VLBlockPool::setMaxCachedBytes.
+ */
+#define VLPOOL_DEFAULT_MAX_CACHED_BYTES (std::size_t(1) << 20)
+
+/**
+ * Blocks bigger than this are never cached, they are rare enough and would hog the cache.
+ */
+#define VLPOOL_MAX_BLOCK_BYTES (std::size_t(1) << 16)
+
+/**
+ * Number of size classes up to VLPOOL_MAX_BLOCK_BYTES: 8 of 16 bytes spacing up to 128 bytes,
+ * then 4 per power of two.
+ */
+#define VLPOOL_BUCKET_COUNT (8 + (16 - 7) * 4)
+
+/**
+ * @class VLBlockPool: The per thread cache of free blocks behind VLPoolAllocator.
+ * A block freed on another thread than the one which allocated it simply joins the cache of
+ * the freeing thread. The cache of a thread is released when it exits.
+ */
+class VLBlockPool
+{
+private:
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	/**
+	 * Trivially destructible so it may still be used by destructors running after the
+	 * thread's Flusher, which then bypass the cache.
+	 */
+	struct State
+	{
+		FreeBlock* buckets[VLPOOL_BUCKET_COUNT];
+		std::size_t cachedBytes, maxCachedBytes;
+	};
+
+	/**
+	 * Releases the cache of a thread when it exits.
+	 */
+	struct Flusher
+	{
+		~Flusher()
+		{
+			flush();
+			_state().maxCachedBytes = 0;
+		}
+	};
+
+	static State& _state()
+	{
+		thread_local State state = {{}, 0, VLPOOL_DEFAULT_MAX_CACHED_BYTES};
+		return state;
+	}
+
+	/**
+	 * @param bytes
+	 * @return The size class the block of bytes is allocated with.
+	 */
+	static std::size_t _classBytes(std::size_t bytes)
+	{
+		return VLSizeClassGrowth<>::sizeClass(bytes == 0? 1: bytes);
+	}
+
+	/**
+	 * @param classBytes: A size class of at most VLPOOL_MAX_BLOCK_BYTES.
+	 * @return Index of its bucket.
+	 */
+	static std::size_t _bucket(std::size_t classBytes)
+	{
+		if (classBytes <= 128)
+		{
+			return classBytes / 16 - 1;
+		}
+		std::size_t log = 0;
+		for (std::size_t rest = classBytes - 1; rest > 1; rest >>= 1)
+		{
+			++log;
+		}
+		std::size_t spacing = std::size_t(1) << (log - 2);
+		return 8 + (log - 7) * 4 + ((classBytes - (std::size_t(1) << log)) / spacing - 1);
+	}
+public:
+	/**
+	 * @param bytes
+	 * @return A block of at least bytes, from the cache of this thread if it has one.
+	 */
+	static void* allocate(std::size_t bytes)
+	{
+		if (bytes > VLPOOL_MAX_BLOCK_BYTES)
+		{
+			return ::operator new(bytes);
+		}
+		std::size_t classBytes = _classBytes(bytes);
+		State &state = _state();
+		FreeBlock* &head = state.buckets[_bucket(classBytes)];
+		if (head == nullptr)
+		{
+			return ::operator new(classBytes);
+		}
+		FreeBlock* block = head;
+		head = block->next;
+		state.cachedBytes -= classBytes;
+		return block;
+	}
+
+	/**
+	 * Give back a block returned by allocate. It is cached unless the cache of this thread
+	 * would exceed its bound.
+	 * @param block
+	 * @param bytes: The size block was allocated with.
+	 */
+	static void deallocate(void* block, std::size_t bytes) noexcept
+	{
+		std::size_t classBytes = _classBytes(bytes);
+		State &state = _state();
+		if (bytes > VLPOOL_MAX_BLOCK_BYTES || state.cachedBytes + classBytes > state.maxCachedBytes)
+		{
+			::operator delete(block);
+			return;
+		}
+		thread_local Flusher flusher;
+		static_cast<void>(flusher);
+		FreeBlock* &head = state.buckets[_bucket(classBytes)];
+		head = ::new (block) FreeBlock{head};
+		state.cachedBytes += classBytes;
+	}
+
+	/**
+	 * Free all the blocks cached by this thread.
+	 */
+	static void flush() noexcept
+	{
+		State &state = _state();
+		for (FreeBlock* &head : state.buckets)
+		{
+			while (head != nullptr)
+			{
+				FreeBlock* next = head->next;
+				::operator delete(head);
+				head = next;
+			}
+		}
+		state.cachedBytes = 0;
+	}
+
+	/**
+	 * @return The bytes currently cached by this thread.
+	 */
+	static std::size_t cachedBytes() { return _state().cachedBytes; }
+
+	/**
+	 * Bound the bytes this thread caches, flushing the cache if it holds more.
+	 * @param maxCachedBytes
+	 */
+	static void setMaxCachedBytes(std::size_t maxCachedBytes)
+	{
+		State &state = _state();
+		state.maxCachedBytes = maxCachedBytes;
+		if (state.cachedBytes > maxCachedBytes)
+		{
+			flush();
+		}
+	}
+};
+
+/**
+ * @struct VLPoolAllocator: Allocator taking its blocks from VLBlockPool.
+ * @tparam T
+ */
+template<class T>
+struct VLPoolAllocator
+{
+	static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "operator new can't align T.");
+
+	typedef T value_type;
+	typedef std::true_type is_always_equal;
+
+	static constexpr std::size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+	VLPoolAllocator() = default;
+
+	template<class U>
+	VLPoolAllocator(const VLPoolAllocator<U>&) noexcept {}
+
+	T* allocate(std::size_t capacity)
+	{
+		if (capacity > std::size_t(-1) / sizeof(T))
+		{
+			throw std::bad_alloc();
+		}
+		return static_cast<T*>(VLBlockPool::allocate(capacity * sizeof(T)));
+	}
+
+	void deallocate(T* mem, std::size_t capacity) noexcept
+	{
+		VLBlockPool::deallocate(mem, capacity * sizeof(T));
+	}
+
+	template<class U>
+	bool operator==(const VLPoolAllocator<U>&) const noexcept { return true; }
+
+	template<class U>
+	bool operator!=(const VLPoolAllocator<U>&) const noexcept { return false; }
+};
+
+#endif // VLPOOL_ALLOCATOR_HPP
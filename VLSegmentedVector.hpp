@@ -0,0 +1,857 @@
+/**
+ * @author Eli Fivelzon, eli.fivelzon@mail.huji.ac.il
+ * VLSegmentedVector<T, StaticCapacity>: a vector which never moves its elements to grow. The
+ * first StaticCapacity elements are inline, like in VLVector, and the next ones go to heap
+ * segments of doubling sizes, so growing a huge vector allocates one more segment instead of
+ * copying everything into a block 1.5 times bigger, and pointers to the elements stay valid.
+ */
+#ifndef VLSEGMENTED_VECTOR_HPP
+#define VLSEGMENTED_VECTOR_HPP
+#include "VLVector.hpp"
+#include <climits>
+#include <initializer_list>
+#if __has_include(<bit>)
+#include <bit>
+#endif
+
+/**
+ * Minimal size of the first heap segment, the segments double from there.
+ */
+#define VLSEGMENT_MIN_SIZE 16
+
+/**
+ * Segments whose pointers are kept inline, enough for 2^8 times the first segment.
+ */
+#define VLSEGMENT_TABLE_CAPACITY 8
+
+namespace vl_detail
+{
+/**
+ * @param value: Must not be zero.
+ * @return Index of the highest set bit of value.
+ */
+constexpr std::size_t highestBit(std::size_t value)
+{
+#if __cpp_lib_bitops
+	return std::bit_width(value) - 1;
+#elif defined(__GNUC__)
+	return sizeof(unsigned long long) * CHAR_BIT - 1 - __builtin_clzll(value);
+#else
+	std::size_t index = 0;
+	for (; value >>= 1; )
+	{
+		++index;
+	}
+	return index;
+#endif
+}
+
+/**
+ * @param value
+ * @return The smallest power of two not less than value.
+ */
+constexpr std::size_t powerOfTwoCeil(std::size_t value)
+{
+	std::size_t power = 1;
+	while (power < value)
+	{
+		power <<= 1;
+	}
+	return power;
+}
+
+/**
+ * @struct SegmentLayout: Index math of the doubling segments after StaticCapacity inline
+ * elements. Heap segment k holds firstSize << k elements, firstSize being a power of two, so the
+ * segment of an index is found with one highest bit computation.
+ * @tparam StaticCapacity
+ */
+template<std::size_t StaticCapacity>
+struct SegmentLayout
+{
+	static constexpr std::size_t firstSize = powerOfTwoCeil(
+			StaticCapacity > VLSEGMENT_MIN_SIZE? StaticCapacity: VLSEGMENT_MIN_SIZE);
+	static constexpr std::size_t firstShift = highestBit(firstSize);
+
+	/**
+	 * Segments covering every index a std::size_t can hold.
+	 */
+	static constexpr std::size_t maxSegments = sizeof(std::size_t) * CHAR_BIT - firstShift;
+
+	/**
+	 * @param segment
+	 * @return The num of elements of heap segment.
+	 */
+	static constexpr std::size_t segmentSize(std::size_t segment) { return firstSize << segment; }
+
+	/**
+	 * @param segments
+	 * @return The num of elements the inline memory and the first segments hold.
+	 */
+	static constexpr std::size_t capacity(std::size_t segments)
+	{
+		return StaticCapacity + firstSize * ((std::size_t(1) << segments) - 1);
+	}
+
+	/**
+	 * @param index: At least StaticCapacity.
+	 * @return The heap segment of index and its offset there.
+	 */
+	static std::pair<std::size_t, std::size_t> locate(std::size_t index)
+	{
+		// Heap segment k holds the indices whose shifted value has its highest bit at
+		// firstShift + k, the rest of the bits being the offset in the segment.
+		std::size_t shifted = index - StaticCapacity + firstSize;
+		std::size_t bit = highestBit(shifted);
+		return {bit - firstShift, shifted - (std::size_t(1) << bit)};
+	}
+};
+
+/**
+ * @class SegmentIterator: Random access iterator over a VLSegmentedVector or a
+ * VLConcurrentVector. Stepping stays within the current segment and only looks the next one up
+ * when leaving it. An iterator past the last segment looks its segment up again when used, so
+ * one left at the end of a vector follows it as it grows.
+ * @tparam T: The element, const for a const iterator.
+ * @tparam Vector: The container, const for a const iterator.
+ */
+template<class T, class Vector>
+class SegmentIterator
+{
+private:
+	Vector* _vector;
+	std::size_t _index;
+	mutable T* _current;
+	mutable T* _segmentEnd;
+
+	/**
+	 * Point _current to element _index, nullptr past the last segment.
+	 */
+	void _seek() const
+	{
+		if (_index < _vector->capacity())
+		{
+			std::pair<T*, T*> slot = _vector->_locate(_index);
+			_current = slot.first;
+			_segmentEnd = slot.second;
+		}
+		else
+		{
+			_current = _segmentEnd = nullptr;
+		}
+	}
+public:
+	typedef std::random_access_iterator_tag iterator_category;
+	typedef typename std::remove_const<T>::type value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef T* pointer;
+	typedef T& reference;
+
+	SegmentIterator(): _vector(nullptr), _index(0), _current(nullptr), _segmentEnd(nullptr) {}
+
+	/**
+	 * @param vector
+	 * @param index: The element pointed to.
+	 */
+	SegmentIterator(Vector* vector, std::size_t index): _vector(vector), _index(index)
+	{
+		_seek();
+	}
+
+	/**
+	 * Iterator to const iterator conversion.
+	 */
+	template<class U, class Other, typename std::enable_if<
+			std::is_const<T>::value && !std::is_const<U>::value, int>::type = 0>
+	SegmentIterator(const SegmentIterator<U, Other> &other):
+			SegmentIterator(other.vector(), other.index()) {}
+
+	Vector* vector() const { return _vector; }
+
+	/**
+	 * @return The index of the element pointed to.
+	 */
+	std::size_t index() const { return _index; }
+
+	reference operator*() const { return *operator->(); }
+
+	pointer operator->() const
+	{
+		if (_current == nullptr)
+		{
+			_seek();
+		}
+		return _current;
+	}
+
+	reference operator[](difference_type n) const { return (*_vector)[_index + n]; }
+
+	SegmentIterator& operator++()
+	{
+		++_index;
+		if (_current == nullptr || ++_current == _segmentEnd)
+		{
+			_seek();
+		}
+		return *this;
+	}
+
+	SegmentIterator operator++(int)
+	{
+		SegmentIterator old = *this;
+		++*this;
+		return old;
+	}
+
+	SegmentIterator& operator--()
+	{
+		--_index;
+		_seek();
+		return *this;
+	}
+
+	SegmentIterator operator--(int)
+	{
+		SegmentIterator old = *this;
+		--*this;
+		return old;
+	}
+
+	SegmentIterator& operator+=(difference_type n)
+	{
+		_index += n;
+		_seek();
+		return *this;
+	}
+
+	SegmentIterator& operator-=(difference_type n) { return *this += -n; }
+
+	SegmentIterator operator+(difference_type n) const
+	{
+		return SegmentIterator(_vector, _index + n);
+	}
+
+	friend SegmentIterator operator+(difference_type n, const SegmentIterator &it)
+	{
+		return it + n;
+	}
+
+	SegmentIterator operator-(difference_type n) const
+	{
+		return SegmentIterator(_vector, _index - n);
+	}
+
+	difference_type operator-(const SegmentIterator &other) const
+	{
+		return difference_type(_index) - difference_type(other._index);
+	}
+
+	bool operator==(const SegmentIterator &other) const { return _index == other._index; }
+
+	bool operator!=(const SegmentIterator &other) const { return _index != other._index; }
+
+	bool operator<(const SegmentIterator &other) const { return _index < other._index; }
+
+	bool operator>(const SegmentIterator &other) const { return _index > other._index; }
+
+	bool operator<=(const SegmentIterator &other) const { return _index <= other._index; }
+
+	bool operator>=(const SegmentIterator &other) const { return _index >= other._index; }
+};
+}
+
+/**
+ * @class VLSegmentedVector: Vector whose elements never move once constructed (other than by
+ * moving the whole container, which moves the inline ones). Elements [0, StaticCapacity) are
+ * inline, then heap segment k holds firstSegmentSize << k elements (see SegmentLayout), so
+ * push_back keeps every pointer, reference and iterator (but end()) valid. Peak memory while
+ * growing is the new segment, not the old block plus the new one. data() can't exist, flatten()
+ * copies (or moves) the elements to a contiguous VLVector when one is needed, and
+ * for_each_segment() hands out the contiguous spans for bulk loops.
+ * @tparam T
+ * @tparam StaticCapacity
+ * @tparam Allocator
+ */
+template<class T, std::size_t StaticCapacity = DEFAULT_STATIC_CAPACITY,
+		 class Allocator = std::allocator<T>>
+class VLSegmentedVector: private vl_detail::AllocatorHolder<Allocator>
+{
+	static_assert(std::is_same<typename Allocator::value_type, T>::value,
+				  "Allocator::value_type must be T.");
+	static_assert(alignof(T) <= vl_detail::AllocatorAlignment<Allocator>::value,
+				  "Allocator can't align T.");
+
+	template<class, class>
+	friend class vl_detail::SegmentIterator;
+public:
+	typedef T value_type;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef Allocator allocator_type;
+	typedef vl_detail::SegmentIterator<T, VLSegmentedVector> iterator;
+	typedef vl_detail::SegmentIterator<const T, const VLSegmentedVector> const_iterator;
+
+	/**
+	 * The size of the first heap segment.
+	 */
+	static constexpr std::size_t firstSegmentSize = vl_detail::SegmentLayout<
+			StaticCapacity>::firstSize;
+private:
+	typedef std::allocator_traits<Allocator> _AllocTraits;
+	typedef typename _AllocTraits::template rebind_alloc<T*> _TableAllocator;
+	typedef vl_detail::SegmentLayout<StaticCapacity> _Layout;
+
+	alignas(T) unsigned char _staticMem[StaticCapacity > 0? StaticCapacity * sizeof(T): 1];
+
+	/**
+	 * The heap segments, in order. Growing the table moves only the pointers.
+	 */
+	VLVector<T*, VLSEGMENT_TABLE_CAPACITY, VLRatioGrowth<>, std::size_t, _TableAllocator> _segments;
+	std::size_t _size;
+
+	Allocator& _alloc() { return this->allocator(); }
+
+	const Allocator& _alloc() const { return this->allocator(); }
+
+	T* _staticData() const
+	{
+		return reinterpret_cast<T*>(const_cast<unsigned char*>(_staticMem));
+	}
+
+	/**
+	 * @param segment
+	 * @return The num of elements of heap segment.
+	 */
+	static constexpr std::size_t _segmentSize(std::size_t segment)
+	{
+		return _Layout::segmentSize(segment);
+	}
+
+	/**
+	 * @param index: Less than capacity().
+	 * @return The slot of element index and the end of its segment.
+	 */
+	std::pair<T*, T*> _locate(std::size_t index) const
+	{
+		if (index < StaticCapacity)
+		{
+			return {_staticData() + index, _staticData() + StaticCapacity};
+		}
+		std::pair<std::size_t, std::size_t> slot = _Layout::locate(index);
+		T* segment = _segments[slot.first];
+		return {segment + slot.second, segment + _segmentSize(slot.first)};
+	}
+
+	/**
+	 * Allocate the next heap segment.
+	 */
+	void _addSegment();
+
+	/**
+	 * Destroy the elements [first, _size) and make first the size.
+	 */
+	void _truncate(std::size_t first) noexcept;
+
+	/**
+	 * Free the heap segments past the ones holding elements.
+	 */
+	void _freeUnusedSegments() noexcept;
+
+	/**
+	 * Take the elements of other, stealing its heap segments when steal is set. The vector must
+	 * be empty without segments, and other is left empty.
+	 */
+	void _takeElements(VLSegmentedVector &other, bool steal);
+public:
+	VLSegmentedVector(): VLSegmentedVector(Allocator()) {}
+
+	/**
+	 * @param alloc: The allocator of the heap segments.
+	 */
+	explicit VLSegmentedVector(const Allocator &alloc):
+			vl_detail::AllocatorHolder<Allocator>(alloc), _segments(_TableAllocator(alloc)),
+			_size(0) {}
+
+	/**
+	 * Copy constructor.
+	 * @param other
+	 */
+	VLSegmentedVector(const VLSegmentedVector &other);
+
+	/**
+	 * Move constructor, steals the heap segments of other and moves its inline elements.
+	 * @param other
+	 */
+	VLSegmentedVector(VLSegmentedVector &&other) noexcept(std::is_nothrow_move_constructible<
+			T>::value);
+
+	/**
+	 * @param values
+	 * @param alloc
+	 */
+	VLSegmentedVector(std::initializer_list<T> values, const Allocator &alloc = Allocator());
+
+	~VLSegmentedVector()
+	{
+		_truncate(0);
+		_freeUnusedSegments();
+	}
+
+	VLSegmentedVector& operator=(const VLSegmentedVector &other);
+
+	VLSegmentedVector& operator=(VLSegmentedVector &&other);
+
+	std::size_t size() const { return _size; }
+
+	bool empty() const { return _size == 0; }
+
+	/**
+	 * @return The num of elements the inline memory and the heap segments hold.
+	 */
+	std::size_t capacity() const
+	{
+		return _Layout::capacity(_segments.size());
+	}
+
+	std::size_t max_size() const
+	{
+		return std::min<std::size_t>(_AllocTraits::max_size(_alloc()), PTRDIFF_MAX / sizeof(T));
+	}
+
+	Allocator get_allocator() const { return _alloc(); }
+
+	/**
+	 * @return The num of heap segments.
+	 */
+	std::size_t segment_count() const { return _segments.size(); }
+
+	/**
+	 * Allocate heap segments until newCapacity elements fit.
+	 * @param newCapacity
+	 */
+	void reserve(std::size_t newCapacity);
+
+	/**
+	 * Free the heap segments holding no element.
+	 */
+	void shrink_to_fit() { _freeUnusedSegments(); }
+
+	/**
+	 * Erase all the elements, keeping the heap segments.
+	 */
+	void clear() { _truncate(0); }
+
+	/**
+	 * Erase elements or append value initialized ones until there are newSize.
+	 * @param newSize
+	 */
+	void resize(std::size_t newSize);
+
+	/**
+	 * Erase elements or append copies of value until there are newSize.
+	 * @param newSize
+	 * @param value
+	 */
+	void resize(std::size_t newSize, const T &value);
+
+	T& operator[](std::size_t index) { return *_locate(index).first; }
+
+	const T& operator[](std::size_t index) const { return *_locate(index).first; }
+
+	/**
+	 * operator[] throwing std::out_of_range for an index past the end.
+	 */
+	T& at(std::size_t index)
+	{
+		if (index >= _size)
+		{
+			throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
+		}
+		return (*this)[index];
+	}
+
+	const T& at(std::size_t index) const
+	{
+		if (index >= _size)
+		{
+			throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
+		}
+		return (*this)[index];
+	}
+
+	T& front() { return (*this)[0]; }
+
+	const T& front() const { return (*this)[0]; }
+
+	T& back() { return (*this)[_size - 1]; }
+
+	const T& back() const { return (*this)[_size - 1]; }
+
+	/**
+	 * Append an element constructed from args. Only allocates (a new segment) when the last
+	 * one is full, and never moves the other elements.
+	 * @return The new element.
+	 */
+	template<class... Args>
+	T& emplace_back(Args&&... args);
+
+	void push_back(const T &value) { emplace_back(value); }
+
+	void push_back(T &&value) { emplace_back(std::move(value)); }
+
+	/**
+	 * Erase the last element.
+	 */
+	void pop_back() { _truncate(_size - 1); }
+
+	/**
+	 * Call f(first, count) for each contiguous span of elements, in order.
+	 * @param f
+	 */
+	template<class Function>
+	void for_each_segment(Function f);
+
+	template<class Function>
+	void for_each_segment(Function f) const;
+
+	/**
+	 * @tparam Vector: A contiguous container with VLVector's reserve and insert.
+	 * @return A copy of the elements in contiguous memory.
+	 */
+	template<class Vector = VLVector<T, StaticCapacity, VLRatioGrowth<>, std::size_t, Allocator>>
+	Vector flatten() const &;
+
+	/**
+	 * @tparam Vector: A contiguous container with VLVector's reserve and insert.
+	 * @return The elements moved to contiguous memory, this vector is left empty.
+	 */
+	template<class Vector = VLVector<T, StaticCapacity, VLRatioGrowth<>, std::size_t, Allocator>>
+	Vector flatten() &&;
+
+	/**
+	 * Swap the elements of the vectors.
+	 * @param other
+	 */
+	void swap(VLSegmentedVector &other);
+
+	iterator begin() { return iterator(this, 0); }
+
+	const_iterator begin() const { return const_iterator(this, 0); }
+
+	const_iterator cbegin() const { return begin(); }
+
+	iterator end() { return iterator(this, _size); }
+
+	const_iterator end() const { return const_iterator(this, _size); }
+
+	const_iterator cend() const { return end(); }
+
+	bool operator==(const VLSegmentedVector &other) const
+	{
+		return _size == other._size && std::equal(begin(), end(), other.begin());
+	}
+
+	bool operator!=(const VLSegmentedVector &other) const { return !(*this == other); }
+};
+
+#define VLSEGMENTED_TEMPLATE template<class T, std::size_t StaticCapacity, class Allocator>
+#define VLSEGMENTED_CLASS VLSegmentedVector<T, StaticCapacity, Allocator>
+
+VLSEGMENTED_TEMPLATE
+void VLSEGMENTED_CLASS::_addSegment()
+{
+	if (capacity() > max_size() - _segmentSize(_segments.size()))
+	{
+		throw std::length_error(LENGTH_ERR_MSG);
+	}
+	std::size_t segmentSize = _segmentSize(_segments.size());
+	T* segment = _AllocTraits::allocate(_alloc(), segmentSize);
+	try
+	{
+		_segments.push_back(segment);
+	}
+	catch (...)
+	{
+		_AllocTraits::deallocate(_alloc(), segment, segmentSize);
+		throw;
+	}
+}
+
+VLSEGMENTED_TEMPLATE
+void VLSEGMENTED_CLASS::_truncate(std::size_t first) noexcept
+{
+	for (; _size > first; --_size)
+	{
+		_AllocTraits::destroy(_alloc(), _locate(_size - 1).first);
+	}
+}
+
+VLSEGMENTED_TEMPLATE
+void VLSEGMENTED_CLASS::_freeUnusedSegments() noexcept
+{
+	while (!_segments.empty() && capacity() - _segmentSize(_segments.size() - 1) >= _size)
+	{
+		std::size_t last = _segments.size() - 1;
+		_AllocTraits::deallocate(_alloc(), _segments[last], _segmentSize(last));
+		_segments.pop_back();
+	}
+}
+
+VLSEGMENTED_TEMPLATE
+void VLSEGMENTED_CLASS::_takeElements(VLSegmentedVector &other, bool steal)
+{
+	if (!steal)
+	{
+		reserve(other._size);
+		for (T &value: other)
+		{
+			emplace_back(std::move(value));
+		}
+		other._truncate(0);
+		return;
+	}
+	// Only the inline elements move, the heap segments change hands.
+	std::size_t inlineCount = std::min(other._size, StaticCapacity);
+	for (; _size < inlineCount; ++_size)
+	{
+		_AllocTraits::construct(_alloc(), _staticData() + _size,
+								std::move_if_noexcept(other._staticData()[_size]));
+	}
+	for (std::size_t index = 0; index < inlineCount; ++index)
+	{
+		_AllocTraits::destroy(other._alloc(), other._staticData() + index);
+	}
+	_segments = std::move(other._segments);
+	other._segments.clear();
+	_size = other._size;
+	other._size = 0;
+}
+
+VLSEGMENTED_TEMPLATE
+VLSEGMENTED_CLASS::VLSegmentedVector(const VLSegmentedVector &other):
+		VLSegmentedVector(_AllocTraits::select_on_container_copy_construction(other._alloc()))
+{
+	try
+	{
+		reserve(other._size);
+		for (const T &value: other)
+		{
+			emplace_back(value);
+		}
+	}
+	catch (...)
+	{
+		_truncate(0);
+		_freeUnusedSegments();
+		throw;
+	}
+}
+
+VLSEGMENTED_TEMPLATE
+VLSEGMENTED_CLASS::VLSegmentedVector(VLSegmentedVector &&other) noexcept(
+		std::is_nothrow_move_constructible<T>::value): VLSegmentedVector(other._alloc())
+{
+	_takeElements(other, true);
+}
+
+VLSEGMENTED_TEMPLATE
+VLSEGMENTED_CLASS::VLSegmentedVector(std::initializer_list<T> values, const Allocator &alloc):
+		VLSegmentedVector(alloc)
+{
+	try
+	{
+		reserve(values.size());
+		for (const T &value: values)
+		{
+			emplace_back(value);
+		}
+	}
+	catch (...)
+	{
+		_truncate(0);
+		_freeUnusedSegments();
+		throw;
+	}
+}
+
+VLSEGMENTED_TEMPLATE
+VLSEGMENTED_CLASS& VLSEGMENTED_CLASS::operator=(const VLSegmentedVector &other)
+{
+	if (&other == this)
+	{
+		return *this;
+	}
+	_truncate(0);
+	if constexpr (_AllocTraits::propagate_on_container_copy_assignment::value)
+	{
+		if (!_AllocTraits::is_always_equal::value && _alloc() != other._alloc())
+		{
+			// The current segments belong to the old allocator.
+			_freeUnusedSegments();
+		}
+		_alloc() = other._alloc();
+	}
+	reserve(other._size);
+	for (const T &value: other)
+	{
+		emplace_back(value);
+	}
+	return *this;
+}
+
+VLSEGMENTED_TEMPLATE
+VLSEGMENTED_CLASS& VLSEGMENTED_CLASS::operator=(VLSegmentedVector &&other)
+{
+	if (&other == this)
+	{
+		return *this;
+	}
+	_truncate(0);
+	_freeUnusedSegments();
+	bool steal = _AllocTraits::is_always_equal::value || _alloc() == other._alloc();
+	if constexpr (_AllocTraits::propagate_on_container_move_assignment::value)
+	{
+		_alloc() = other._alloc();
+		steal = true;
+	}
+	_takeElements(other, steal);
+	return *this;
+}
+
+VLSEGMENTED_TEMPLATE
+void VLSEGMENTED_CLASS::reserve(std::size_t newCapacity)
+{
+	if (newCapacity > max_size())
+	{
+		throw std::length_error(LENGTH_ERR_MSG);
+	}
+	while (capacity() < newCapacity)
+	{
+		_addSegment();
+	}
+}
+
+VLSEGMENTED_TEMPLATE
+void VLSEGMENTED_CLASS::resize(std::size_t newSize)
+{
+	reserve(newSize);
+	_truncate(newSize);
+	while (_size < newSize)
+	{
+		emplace_back();
+	}
+}
+
+VLSEGMENTED_TEMPLATE
+void VLSEGMENTED_CLASS::resize(std::size_t newSize, const T &value)
+{
+	reserve(newSize);
+	_truncate(newSize);
+	while (_size < newSize)
+	{
+		emplace_back(value);
+	}
+}
+
+VLSEGMENTED_TEMPLATE
+template<class... Args>
+T& VLSEGMENTED_CLASS::emplace_back(Args&&... args)
+{
+	if (_size == capacity())
+	{
+		// The new segment doesn't move anything, args stay valid.
+		_addSegment();
+	}
+	T* slot = _locate(_size).first;
+	_AllocTraits::construct(_alloc(), slot, std::forward<Args>(args)...);
+	++_size;
+	return *slot;
+}
+
+VLSEGMENTED_TEMPLATE
+template<class Function>
+void VLSEGMENTED_CLASS::for_each_segment(Function f)
+{
+	std::size_t count = std::min(_size, StaticCapacity);
+	if (count > 0)
+	{
+		f(_staticData(), count);
+	}
+	for (std::size_t segment = 0, left = _size - count; left > 0; ++segment)
+	{
+		count = std::min(left, _segmentSize(segment));
+		f(_segments[segment], count);
+		left -= count;
+	}
+}
+
+VLSEGMENTED_TEMPLATE
+template<class Function>
+void VLSEGMENTED_CLASS::for_each_segment(Function f) const
+{
+	const_cast<VLSegmentedVector*>(this)->for_each_segment([&](T* first, std::size_t count)
+														   {
+															   f(static_cast<const T*>(first),
+																 count);
+														   });
+}
+
+VLSEGMENTED_TEMPLATE
+template<class Vector>
+Vector VLSEGMENTED_CLASS::flatten() const &
+{
+	Vector flat(_alloc());
+	flat.reserve(_size);
+	for_each_segment([&](const T* first, std::size_t count)
+					 {
+						 flat.insert(flat.end(), first, first + count);
+					 });
+	return flat;
+}
+
+VLSEGMENTED_TEMPLATE
+template<class Vector>
+Vector VLSEGMENTED_CLASS::flatten() &&
+{
+	Vector flat(_alloc());
+	flat.reserve(_size);
+	for_each_segment([&](T* first, std::size_t count)
+					 {
+						 flat.insert(flat.end(), std::make_move_iterator(first),
+									 std::make_move_iterator(first + count));
+					 });
+	_truncate(0);
+	_freeUnusedSegments();
+	return flat;
+}
+
+VLSEGMENTED_TEMPLATE
+void VLSEGMENTED_CLASS::swap(VLSegmentedVector &other)
+{
+	if (&other == this)
+	{
+		return;
+	}
+	// The moves carry the allocators along as far as they propagate on move assignment.
+	VLSegmentedVector elements(std::move(other));
+	other = std::move(*this);
+	*this = std::move(elements);
+}
+
+/**
+ * Swap the elements of the vectors.
+ * @param first
+ * @param second
+ */
+VLSEGMENTED_TEMPLATE
+void swap(VLSEGMENTED_CLASS &first, VLSEGMENTED_CLASS &second)
+{
+	first.swap(second);
+}
+
+#undef VLSEGMENTED_CLASS
+#undef VLSEGMENTED_TEMPLATE
+
+#endif // VLSEGMENTED_VECTOR_HPP
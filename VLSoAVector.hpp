@@ -0,0 +1,1017 @@
+/**
+ * @author Eli Fivelzon, eli.fivelzon@mail.huji.ac.il
+ * VLSoAVector<std::tuple<Ts...>, StaticCapacity>: a vector of rows stored as a struct of
+ * arrays, one contiguous column per field, so a loop over one field streams through that field
+ * only. Like VLVector the rows live inline until they outgrow StaticCapacity and then on the
+ * heap, with the same growth and demotion policies, and all the columns share one memory.
+ */
+#ifndef VLSOA_VECTOR_HPP
+#define VLSOA_VECTOR_HPP
+#include "VLVector.hpp"
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <tuple>
+#if __has_include(<span>)
+#include <span>
+#endif
+
+namespace vl_detail
+{
+/**
+ * @param capacity
+ * @return The offset of every column of a memory holding capacity rows of Ts, followed by the
+ * bytes of that memory. Each column is aligned for its type, the first one starts the memory.
+ */
+template<class... Ts>
+constexpr std::array<std::size_t, sizeof...(Ts) + 1> soaLayout(std::size_t capacity)
+{
+	constexpr std::size_t sizes[] = {sizeof(Ts)...}, alignments[] = {alignof(Ts)...};
+	std::array<std::size_t, sizeof...(Ts) + 1> layout{};
+	std::size_t offset = 0;
+	for (std::size_t i = 0; i < sizeof...(Ts); ++i)
+	{
+		offset = (offset + alignments[i] - 1) / alignments[i] * alignments[i];
+		layout[i] = offset;
+		offset += capacity * sizes[i];
+	}
+	layout[sizeof...(Ts)] = offset;
+	return layout;
+}
+
+/**
+ * @class SoAIterator: Random access iterator over the rows of a VLSoAVector. Dereferencing
+ * gives a std::tuple of references to the fields of the row, so it works with algorithms
+ * reading rows or assigning them through *it, but not with ones swapping them (e.g. std::sort).
+ * @tparam IsConst
+ * @tparam Ts: The columns.
+ */
+template<bool IsConst, class... Ts>
+class SoAIterator
+{
+public:
+	typedef std::random_access_iterator_tag iterator_category;
+	typedef std::tuple<Ts...> value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef void pointer;
+	typedef std::tuple<typename std::conditional<IsConst, const Ts&, Ts&>::type...> reference;
+	typedef std::tuple<typename std::conditional<IsConst, const Ts, Ts>::type*...> Columns;
+private:
+	Columns _columns;
+	std::ptrdiff_t _index;
+
+	template<std::size_t... Is>
+	reference _row(std::ptrdiff_t index, std::index_sequence<Is...>) const
+	{
+		return reference(std::get<Is>(_columns)[index]...);
+	}
+public:
+	SoAIterator(): _columns(), _index(0) {}
+
+	/**
+	 * @param columns: The first row of every column.
+	 * @param index: The row pointed to.
+	 */
+	SoAIterator(const Columns &columns, std::ptrdiff_t index): _columns(columns), _index(index) {}
+
+	/**
+	 * Iterator to const iterator conversion.
+	 */
+	template<bool WasConst, typename std::enable_if<IsConst && !WasConst, int>::type = 0>
+	SoAIterator(const SoAIterator<WasConst, Ts...> &other):
+			_columns(other.columns()), _index(other.index()) {}
+
+	/**
+	 * @return The first row of every column.
+	 */
+	const Columns& columns() const { return _columns; }
+
+	/**
+	 * @return The index of the row pointed to.
+	 */
+	std::ptrdiff_t index() const { return _index; }
+
+	reference operator*() const { return _row(_index, std::index_sequence_for<Ts...>()); }
+
+	reference operator[](difference_type n) const
+	{
+		return _row(_index + n, std::index_sequence_for<Ts...>());
+	}
+
+	SoAIterator& operator++()
+	{
+		++_index;
+		return *this;
+	}
+
+	SoAIterator operator++(int)
+	{
+		SoAIterator old = *this;
+		++_index;
+		return old;
+	}
+
+	SoAIterator& operator--()
+	{
+		--_index;
+		return *this;
+	}
+
+	SoAIterator operator--(int)
+	{
+		SoAIterator old = *this;
+		--_index;
+		return old;
+	}
+
+	SoAIterator& operator+=(difference_type n)
+	{
+		_index += n;
+		return *this;
+	}
+
+	SoAIterator& operator-=(difference_type n)
+	{
+		_index -= n;
+		return *this;
+	}
+
+	SoAIterator operator+(difference_type n) const { return SoAIterator(_columns, _index + n); }
+
+	friend SoAIterator operator+(difference_type n, const SoAIterator &it) { return it + n; }
+
+	SoAIterator operator-(difference_type n) const { return SoAIterator(_columns, _index - n); }
+
+	difference_type operator-(const SoAIterator &other) const { return _index - other._index; }
+
+	bool operator==(const SoAIterator &other) const { return _index == other._index; }
+
+	bool operator!=(const SoAIterator &other) const { return _index != other._index; }
+
+	bool operator<(const SoAIterator &other) const { return _index < other._index; }
+
+	bool operator>(const SoAIterator &other) const { return _index > other._index; }
+
+	bool operator<=(const SoAIterator &other) const { return _index <= other._index; }
+
+	bool operator>=(const SoAIterator &other) const { return _index >= other._index; }
+};
+}
+
+/**
+ * @class VLSoAVector: Vector of rows of Ts... kept as one column per field.
+ * The inline memory holds StaticCapacity rows, laid out column after column, and a heap memory
+ * of some capacity is one allocation laid out the same way, so growing relocates every column
+ * with a single allocation. Capacities follow the rule of VLVector (vl_detail::growCapacity)
+ * with GrowthPolicy seeing the bytes of a whole row, and DemotionPolicy decides when erase and
+ * shrink_to_fit move back inline. Allocator allocates bytes; the elements are constructed in
+ * place. Columns are reached with data<I>() (and column<I>(), a std::span, with C++20), rows
+ * with operator[] and the iterators, as std::tuples of references.
+ * @tparam Row: std::tuple<Ts...>, the fields of a row.
+ * @tparam StaticCapacity
+ * @tparam GrowthPolicy
+ * @tparam Allocator
+ * @tparam DemotionPolicy
+ */
+template<class Row, std::size_t StaticCapacity = DEFAULT_STATIC_CAPACITY,
+		 class GrowthPolicy = VLRatioGrowth<>, class Allocator = std::allocator<unsigned char>,
+		 class DemotionPolicy = VLDemoteAtCapacity>
+class VLSoAVector;
+
+template<class... Ts, std::size_t StaticCapacity, class GrowthPolicy, class Allocator,
+		 class DemotionPolicy>
+class VLSoAVector<std::tuple<Ts...>, StaticCapacity, GrowthPolicy, Allocator, DemotionPolicy>:
+		private vl_detail::AllocatorHolder<Allocator>
+{
+	static_assert(sizeof...(Ts) > 0, "VLSoAVector needs at least one column.");
+	static_assert(sizeof(typename Allocator::value_type) == 1, "Allocator must allocate bytes.");
+	static_assert(std::max({alignof(Ts)...}) <= vl_detail::AllocatorAlignment<Allocator>::value,
+				  "Allocator can't align every column.");
+public:
+	typedef std::tuple<Ts...> value_type;
+	typedef std::tuple<Ts&...> reference;
+	typedef std::tuple<const Ts&...> const_reference;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef Allocator allocator_type;
+	typedef vl_detail::SoAIterator<false, Ts...> iterator;
+	typedef vl_detail::SoAIterator<true, Ts...> const_iterator;
+
+	/**
+	 * @typedef column_type: The type of column I.
+	 */
+	template<std::size_t I>
+	using column_type = typename std::tuple_element<I, value_type>::type;
+private:
+	typedef std::allocator_traits<Allocator> _AllocTraits;
+	typedef typename Allocator::value_type _Byte;
+	typedef std::tuple<Ts*...> _Columns;
+	typedef std::index_sequence_for<Ts...> _Indices;
+
+	/**
+	 * The bytes of one row, the element size GrowthPolicy sees.
+	 */
+	static constexpr std::size_t _rowBytes = (sizeof(Ts) + ...);
+
+	static constexpr std::size_t _staticBytes = vl_detail::soaLayout<Ts...>(StaticCapacity).back();
+
+	/**
+	 * Whether a relocation copies some column, whose move may throw. Then it copies the other
+	 * columns too, so a throw leaves every source column as it was.
+	 */
+	static constexpr bool _relocationCopies = ((!std::is_nothrow_move_constructible<Ts>::value
+												&& std::is_copy_constructible<Ts>::value) || ...);
+
+	alignas(Ts...) unsigned char _staticMem[_staticBytes > 0? _staticBytes: 1];
+	_Columns _columns;
+	std::size_t _size, _capacity;
+
+	/**
+	 * Set by reserve() so erase won't move the rows back inline, cleared by shrink_to_fit().
+	 */
+	bool _pinned;
+
+	Allocator& _alloc() { return this->allocator(); }
+
+	const Allocator& _alloc() const { return this->allocator(); }
+
+	bool _onHeap() const { return _capacity > StaticCapacity; }
+
+	/**
+	 * @param mem
+	 * @param capacity
+	 * @return The columns of mem when it holds capacity rows.
+	 */
+	template<std::size_t... Is>
+	static _Columns _columnsAt(unsigned char* mem, std::size_t capacity,
+							   std::index_sequence<Is...>)
+	{
+		constexpr std::size_t count = sizeof...(Ts);
+		std::array<std::size_t, count + 1> layout = vl_detail::soaLayout<Ts...>(capacity);
+		return _Columns(reinterpret_cast<Ts*>(mem + layout[Is])...);
+	}
+
+	/**
+	 * @param capacity
+	 * @return The inline memory if capacity is at most StaticCapacity, otherwise a heap memory of
+	 * capacity rows.
+	 */
+	unsigned char* _allocate(std::size_t capacity);
+
+	/**
+	 * Free a memory returned by _allocate.
+	 * @param mem
+	 * @param capacity: The capacity mem was allocated with.
+	 */
+	void _deallocate(unsigned char* mem, std::size_t capacity) noexcept;
+
+	/**
+	 * @return The current memory, whose first column starts it.
+	 */
+	unsigned char* _mem() const { return reinterpret_cast<unsigned char*>(std::get<0>(_columns)); }
+
+	/**
+	 * Copy (or relocate, moving when no column can throw and destroying nothing) count rows of
+	 * every column of from into the uninitialized columns of to. If an element throws, what was
+	 * built is destroyed again and from is untouched.
+	 * @tparam Relocate
+	 * @param from
+	 * @param count
+	 * @param to
+	 */
+	template<bool Relocate, std::size_t... Is>
+	static void _transferRows(const _Columns &from, std::size_t count, const _Columns &to,
+							  std::index_sequence<Is...>);
+
+	/**
+	 * One column of _transferRows.
+	 */
+	template<bool Relocate, class T>
+	static void _transferColumn(const T* first, std::size_t count, T* dest);
+
+	/**
+	 * Destroy count elements of a column relocated by _transferRows, either the originals after
+	 * the relocation or the copies when it failed. Bitwise relocated ones are left alone.
+	 */
+	template<class T>
+	static void _endRelocation(T* first, std::size_t count) noexcept;
+
+	/**
+	 * Destroy the rows [first, last) of columns.
+	 */
+	static void _destroyRows(const _Columns &columns, std::size_t first, std::size_t last) noexcept;
+
+	/**
+	 * Construct row index of columns, field by field from values. If a field throws, the ones
+	 * already built are destroyed.
+	 */
+	template<class... Us, std::size_t... Is>
+	static void _constructRow(const _Columns &columns, std::size_t index,
+							  std::index_sequence<Is...>, Us&&... values);
+
+	/**
+	 * Move the rows to a memory of newCapacity (the inline memory if it is at most
+	 * StaticCapacity). If values are given, a row built from them is appended at the same time,
+	 * before the old rows move, so values may refer to them. Strong exception guarantee.
+	 * @param newCapacity: At least size() (plus one with values).
+	 * @param values: Empty or one per column.
+	 */
+	template<class... Us>
+	void _reallocate(std::size_t newCapacity, Us&&... values);
+
+	/**
+	 * Move the rows to the inline memory if DemotionPolicy says so after an erase.
+	 */
+	void _demote();
+
+	/**
+	 * Give back the heap memory (the vector must be empty) and point at the inline memory.
+	 */
+	void _release() noexcept;
+
+	/**
+	 * @return True if the columns of the vectors, of the same size, hold equal elements.
+	 */
+	template<std::size_t... Is>
+	bool _equalRows(const VLSoAVector &other, std::index_sequence<Is...>) const
+	{
+		return (std::equal(std::get<Is>(_columns), std::get<Is>(_columns) + _size,
+						   std::get<Is>(other._columns)) && ...);
+	}
+
+	/**
+	 * Take the rows of other, stealing its heap memory when steal is set and it has one. The
+	 * vector must be empty and inline, and other is left empty.
+	 */
+	void _takeRows(VLSoAVector &other, bool steal);
+public:
+	VLSoAVector(): VLSoAVector(Allocator()) {}
+
+	/**
+	 * @param alloc: The allocator of the heap memory.
+	 */
+	explicit VLSoAVector(const Allocator &alloc);
+
+	/**
+	 * Copy constructor.
+	 * @param other
+	 */
+	VLSoAVector(const VLSoAVector &other);
+
+	/**
+	 * Move constructor, steals the heap memory of other.
+	 * @param other
+	 */
+	VLSoAVector(VLSoAVector &&other) noexcept(
+			((VLIsTriviallyRelocatable<Ts>::value || std::is_nothrow_move_constructible<Ts>::value)
+			 && ...));
+
+	/**
+	 * @param rows
+	 * @param alloc
+	 */
+	VLSoAVector(std::initializer_list<value_type> rows, const Allocator &alloc = Allocator());
+
+	~VLSoAVector();
+
+	VLSoAVector& operator=(const VLSoAVector &other);
+
+	VLSoAVector& operator=(VLSoAVector &&other);
+
+	/**
+	 * @return The num of rows.
+	 */
+	std::size_t size() const { return _size; }
+
+	bool empty() const { return _size == 0; }
+
+	/**
+	 * @return The num of rows the current memory holds.
+	 */
+	std::size_t capacity() const { return _capacity; }
+
+	/**
+	 * @return The max num of rows.
+	 */
+	std::size_t max_size() const;
+
+	Allocator get_allocator() const { return _alloc(); }
+
+	/**
+	 * Make room for newCapacity rows. A heap memory allocated so is kept until
+	 * shrink_to_fit(), a reserve which doesn't allocate changes nothing.
+	 * @param newCapacity
+	 */
+	void reserve(std::size_t newCapacity);
+
+	/**
+	 * Fit the memory to size(), moving back inline if DemotionPolicy allows it.
+	 */
+	void shrink_to_fit();
+
+	/**
+	 * Erase rows or append value initialized ones until there are newSize.
+	 * @param newSize
+	 */
+	void resize(std::size_t newSize);
+
+	/**
+	 * Erase all the rows.
+	 */
+	void clear() { erase(cbegin(), cend()); }
+
+	/**
+	 * @param index
+	 * @return The fields of the row.
+	 */
+	reference operator[](std::size_t index) { return begin()[index]; }
+
+	const_reference operator[](std::size_t index) const { return begin()[index]; }
+
+	/**
+	 * operator[] throwing std::out_of_range for an index past the end.
+	 */
+	reference at(std::size_t index);
+
+	const_reference at(std::size_t index) const;
+
+	reference front() { return (*this)[0]; }
+
+	const_reference front() const { return (*this)[0]; }
+
+	reference back() { return (*this)[_size - 1]; }
+
+	const_reference back() const { return (*this)[_size - 1]; }
+
+	/**
+	 * @tparam I
+	 * @return The contiguous size() elements of column I.
+	 */
+	template<std::size_t I>
+	column_type<I>* data() { return std::get<I>(_columns); }
+
+	template<std::size_t I>
+	const column_type<I>* data() const { return std::get<I>(_columns); }
+
+#ifdef __cpp_lib_span
+	/**
+	 * @tparam I
+	 * @return Column I.
+	 */
+	template<std::size_t I>
+	std::span<column_type<I>> column() { return {data<I>(), _size}; }
+
+	template<std::size_t I>
+	std::span<const column_type<I>> column() const { return {data<I>(), _size}; }
+#endif
+
+	/**
+	 * Append a row built field by field from values.
+	 * @param values: One per column.
+	 * @return The new row.
+	 */
+	template<class... Us>
+	reference emplace_back(Us&&... values);
+
+	void push_back(const value_type &row)
+	{
+		std::apply([this](const Ts&... values) { emplace_back(values...); }, row);
+	}
+
+	void push_back(value_type &&row)
+	{
+		std::apply([this](Ts&... values) { emplace_back(std::move(values)...); }, row);
+	}
+
+	/**
+	 * Insert a row built field by field from values before position.
+	 * @param position
+	 * @param values: One per column.
+	 * @return An iterator to the new row.
+	 */
+	template<class... Us>
+	iterator emplace(const_iterator position, Us&&... values);
+
+	iterator insert(const_iterator position, const value_type &row)
+	{
+		return std::apply([&](const Ts&... values) { return emplace(position, values...); }, row);
+	}
+
+	/**
+	 * Erase the last row.
+	 */
+	void pop_back() { erase(cend() - 1); }
+
+	/**
+	 * @param position
+	 * @return An iterator to the row which followed the erased one.
+	 */
+	iterator erase(const_iterator position) { return erase(position, position + 1); }
+
+	/**
+	 * Erase the rows [first, last), keeping the order of the others.
+	 * @param first
+	 * @param last
+	 * @return An iterator to the row which followed the erased ones.
+	 */
+	iterator erase(const_iterator first, const_iterator last);
+
+	/**
+	 * Swap the rows of the vectors.
+	 * @param other
+	 */
+	void swap(VLSoAVector &other);
+
+	iterator begin() { return iterator(_columns, 0); }
+
+	const_iterator begin() const { return const_iterator(_columns, 0); }
+
+	const_iterator cbegin() const { return begin(); }
+
+	iterator end() { return begin() + _size; }
+
+	const_iterator end() const { return begin() + _size; }
+
+	const_iterator cend() const { return end(); }
+
+	/**
+	 * @param other
+	 * @return True if the vectors hold equal rows.
+	 */
+	bool operator==(const VLSoAVector &other) const;
+
+	bool operator!=(const VLSoAVector &other) const { return !(*this == other); }
+};
+
+#define VLSOA_TEMPLATE template<class... Ts, std::size_t StaticCapacity, class GrowthPolicy, \
+									 class Allocator, class DemotionPolicy>
+#define VLSOA_CLASS VLSoAVector<std::tuple<Ts...>, StaticCapacity, GrowthPolicy, Allocator, \
+								DemotionPolicy>
+
+VLSOA_TEMPLATE
+unsigned char* VLSOA_CLASS::_allocate(std::size_t capacity)
+{
+	if (capacity <= StaticCapacity)
+	{
+		return _staticMem;
+	}
+	std::size_t bytes = vl_detail::soaLayout<Ts...>(capacity).back();
+	return reinterpret_cast<unsigned char*>(_AllocTraits::allocate(_alloc(), bytes));
+}
+
+VLSOA_TEMPLATE
+void VLSOA_CLASS::_deallocate(unsigned char* mem, std::size_t capacity) noexcept
+{
+	if (capacity > StaticCapacity)
+	{
+		std::size_t bytes = vl_detail::soaLayout<Ts...>(capacity).back();
+		_AllocTraits::deallocate(_alloc(), reinterpret_cast<_Byte*>(mem), bytes);
+	}
+}
+
+VLSOA_TEMPLATE
+template<bool Relocate, class T>
+void VLSOA_CLASS::_transferColumn(const T* first, std::size_t count, T* dest)
+{
+	if constexpr (Relocate && VLIsTriviallyRelocatable<T>::value)
+	{
+		if (count > 0)
+		{
+			std::memcpy(static_cast<void*>(dest), static_cast<const void*>(first),
+						count * sizeof(T));
+		}
+	}
+	else if constexpr (Relocate && ((std::is_nothrow_move_constructible<T>::value
+									 && !_relocationCopies)
+									|| !std::is_copy_constructible<T>::value))
+	{
+		T* source = const_cast<T*>(first);
+		std::uninitialized_copy(std::make_move_iterator(source),
+								std::make_move_iterator(source + count), dest);
+	}
+	else
+	{
+		std::uninitialized_copy(first, first + count, dest);
+	}
+}
+
+VLSOA_TEMPLATE
+template<class T>
+void VLSOA_CLASS::_endRelocation(T* first, std::size_t count) noexcept
+{
+	if constexpr (!VLIsTriviallyRelocatable<T>::value)
+	{
+		std::destroy(first, first + count);
+	}
+}
+
+VLSOA_TEMPLATE
+template<bool Relocate, std::size_t... Is>
+void VLSOA_CLASS::_transferRows(const _Columns &from, std::size_t count, const _Columns &to,
+								std::index_sequence<Is...>)
+{
+	std::size_t built = 0;
+	try
+	{
+		((_transferColumn<Relocate>(std::get<Is>(from), count, std::get<Is>(to)), ++built), ...);
+	}
+	catch (...)
+	{
+		if constexpr (Relocate)
+		{
+			((Is < built? _endRelocation(std::get<Is>(to), count): void()), ...);
+		}
+		else
+		{
+			((Is < built? std::destroy(std::get<Is>(to), std::get<Is>(to) + count): void()), ...);
+		}
+		throw;
+	}
+}
+
+VLSOA_TEMPLATE
+void VLSOA_CLASS::_destroyRows(const _Columns &columns, std::size_t first,
+							   std::size_t last) noexcept
+{
+	std::apply([=](Ts*... column) { (std::destroy(column + first, column + last), ...); }, columns);
+}
+
+VLSOA_TEMPLATE
+template<class... Us, std::size_t... Is>
+void VLSOA_CLASS::_constructRow(const _Columns &columns, std::size_t index,
+								std::index_sequence<Is...>, Us&&... values)
+{
+	static_assert(sizeof...(Us) == sizeof...(Ts), "A row takes one value per column.");
+	std::size_t built = 0;
+	try
+	{
+		((::new (static_cast<void*>(std::get<Is>(columns) + index)) Ts(std::forward<Us>(values)),
+		  ++built), ...);
+	}
+	catch (...)
+	{
+		((Is < built? std::destroy_at(std::get<Is>(columns) + index): void()), ...);
+		throw;
+	}
+}
+
+VLSOA_TEMPLATE
+template<class... Us>
+void VLSOA_CLASS::_reallocate(std::size_t newCapacity, Us&&... values)
+{
+	newCapacity = std::max(newCapacity, StaticCapacity);
+	unsigned char* mem = _allocate(newCapacity);
+	_Columns columns = _columnsAt(mem, newCapacity, _Indices());
+	try
+	{
+		if constexpr (sizeof...(Us) > 0)
+		{
+			_constructRow(columns, _size, _Indices(), std::forward<Us>(values)...);
+		}
+		try
+		{
+			_transferRows<true>(_columns, _size, columns, _Indices());
+		}
+		catch (...)
+		{
+			if constexpr (sizeof...(Us) > 0)
+			{
+				_destroyRows(columns, _size, _size + 1);
+			}
+			throw;
+		}
+	}
+	catch (...)
+	{
+		_deallocate(mem, newCapacity);
+		throw;
+	}
+	std::apply([this](Ts*... column) { (_endRelocation(column, _size), ...); }, _columns);
+	_deallocate(_mem(), _capacity);
+	_columns = columns;
+	_capacity = newCapacity;
+	_size += sizeof...(Us) > 0? 1: 0;
+	if (!_onHeap())
+	{
+		_pinned = false;
+	}
+}
+
+VLSOA_TEMPLATE
+void VLSOA_CLASS::_demote()
+{
+	if (_onHeap() && !_pinned && DemotionPolicy::onErase(_size, StaticCapacity))
+	{
+		_reallocate(StaticCapacity);
+	}
+}
+
+VLSOA_TEMPLATE
+void VLSOA_CLASS::_release() noexcept
+{
+	_deallocate(_mem(), _capacity);
+	_columns = _columnsAt(_staticMem, StaticCapacity, _Indices());
+	_capacity = StaticCapacity;
+	_pinned = false;
+}
+
+VLSOA_TEMPLATE
+void VLSOA_CLASS::_takeRows(VLSoAVector &other, bool steal)
+{
+	if (steal && other._onHeap())
+	{
+		_columns = other._columns;
+		_capacity = other._capacity;
+		_size = other._size;
+		_pinned = other._pinned;
+		other._columns = _columnsAt(other._staticMem, StaticCapacity, _Indices());
+		other._size = 0;
+		other._capacity = StaticCapacity;
+		other._pinned = false;
+		return;
+	}
+	if (other._size > _capacity)
+	{
+		_reallocate(other._size);
+	}
+	_transferRows<true>(other._columns, other._size, _columns, _Indices());
+	std::apply([&](Ts*... column) { (_endRelocation(column, other._size), ...); }, other._columns);
+	_size = other._size;
+	other._size = 0;
+}
+
+VLSOA_TEMPLATE
+VLSOA_CLASS::VLSoAVector(const Allocator &alloc):
+		vl_detail::AllocatorHolder<Allocator>(alloc),
+		_columns(_columnsAt(_staticMem, StaticCapacity, _Indices())), _size(0),
+		_capacity(StaticCapacity), _pinned(false) {}
+
+VLSOA_TEMPLATE
+VLSOA_CLASS::VLSoAVector(const VLSoAVector &other):
+		VLSoAVector(_AllocTraits::select_on_container_copy_construction(other._alloc()))
+{
+	if (other._size > _capacity)
+	{
+		_reallocate(other._size);
+	}
+	try
+	{
+		_transferRows<false>(other._columns, other._size, _columns, _Indices());
+	}
+	catch (...)
+	{
+		_release();
+		throw;
+	}
+	_size = other._size;
+}
+
+VLSOA_TEMPLATE
+VLSOA_CLASS::VLSoAVector(VLSoAVector &&other) noexcept(
+		((VLIsTriviallyRelocatable<Ts>::value || std::is_nothrow_move_constructible<Ts>::value)
+		 && ...)): VLSoAVector(other._alloc())
+{
+	_takeRows(other, true);
+}
+
+VLSOA_TEMPLATE
+VLSOA_CLASS::VLSoAVector(std::initializer_list<value_type> rows, const Allocator &alloc):
+		VLSoAVector(alloc)
+{
+	try
+	{
+		reserve(rows.size());
+		_pinned = false;
+		for (const value_type &row: rows)
+		{
+			push_back(row);
+		}
+	}
+	catch (...)
+	{
+		_destroyRows(_columns, 0, _size);
+		_size = 0;
+		_release();
+		throw;
+	}
+}
+
+VLSOA_TEMPLATE
+VLSOA_CLASS::~VLSoAVector()
+{
+	_destroyRows(_columns, 0, _size);
+	_deallocate(_mem(), _capacity);
+}
+
+VLSOA_TEMPLATE
+VLSOA_CLASS& VLSOA_CLASS::operator=(const VLSoAVector &other)
+{
+	if (&other == this)
+	{
+		return *this;
+	}
+	_destroyRows(_columns, 0, _size);
+	_size = 0;
+	if constexpr (_AllocTraits::propagate_on_container_copy_assignment::value)
+	{
+		if (!_AllocTraits::is_always_equal::value && _alloc() != other._alloc())
+		{
+			// The current memory belongs to the old allocator.
+			_release();
+		}
+		_alloc() = other._alloc();
+	}
+	if (other._size > _capacity)
+	{
+		_reallocate(other._size);
+	}
+	_transferRows<false>(other._columns, other._size, _columns, _Indices());
+	_size = other._size;
+	return *this;
+}
+
+VLSOA_TEMPLATE
+VLSOA_CLASS& VLSOA_CLASS::operator=(VLSoAVector &&other)
+{
+	if (&other == this)
+	{
+		return *this;
+	}
+	_destroyRows(_columns, 0, _size);
+	_size = 0;
+	_release();
+	bool steal = _AllocTraits::is_always_equal::value || _alloc() == other._alloc();
+	if constexpr (_AllocTraits::propagate_on_container_move_assignment::value)
+	{
+		_alloc() = other._alloc();
+		steal = true;
+	}
+	_takeRows(other, steal);
+	return *this;
+}
+
+VLSOA_TEMPLATE
+std::size_t VLSOA_CLASS::max_size() const
+{
+	// Every column may need up to its alignment of padding.
+	constexpr std::size_t padding = (alignof(Ts) + ...);
+	std::size_t bytes = std::min<std::size_t>(_AllocTraits::max_size(_alloc()), PTRDIFF_MAX);
+	return bytes < padding? 0: (bytes - padding) / _rowBytes;
+}
+
+VLSOA_TEMPLATE
+void VLSOA_CLASS::reserve(std::size_t newCapacity)
+{
+	if (newCapacity > max_size())
+	{
+		throw std::length_error(LENGTH_ERR_MSG);
+	}
+	if (newCapacity > _capacity)
+	{
+		_reallocate(newCapacity);
+		_pinned = true;
+	}
+}
+
+VLSOA_TEMPLATE
+void VLSOA_CLASS::shrink_to_fit()
+{
+	_pinned = false;
+	if (!_onHeap())
+	{
+		return;
+	}
+	// A heap memory must stay bigger than StaticCapacity to be told apart from the inline one.
+	bool toInline = DemotionPolicy::onShrink && _size <= StaticCapacity;
+	std::size_t newCapacity = toInline? StaticCapacity: std::max(_size, StaticCapacity + 1);
+	if (newCapacity < _capacity)
+	{
+		_reallocate(newCapacity);
+	}
+}
+
+VLSOA_TEMPLATE
+void VLSOA_CLASS::resize(std::size_t newSize)
+{
+	if (newSize <= _size)
+	{
+		erase(cbegin() + newSize, cend());
+		return;
+	}
+	if (newSize > _capacity)
+	{
+		_reallocate(vl_detail::growCapacity<GrowthPolicy>(_size, newSize - _size, StaticCapacity,
+														   max_size(), _rowBytes));
+	}
+	while (_size < newSize)
+	{
+		_constructRow(_columns, _size, _Indices(), Ts()...);
+		++_size;
+	}
+}
+
+VLSOA_TEMPLATE
+typename VLSOA_CLASS::reference VLSOA_CLASS::at(std::size_t index)
+{
+	if (index >= _size)
+	{
+		throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
+	}
+	return (*this)[index];
+}
+
+VLSOA_TEMPLATE
+typename VLSOA_CLASS::const_reference VLSOA_CLASS::at(std::size_t index) const
+{
+	if (index >= _size)
+	{
+		throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
+	}
+	return (*this)[index];
+}
+
+VLSOA_TEMPLATE
+template<class... Us>
+typename VLSOA_CLASS::reference VLSOA_CLASS::emplace_back(Us&&... values)
+{
+	if (_size == _capacity)
+	{
+		_reallocate(vl_detail::growCapacity<GrowthPolicy>(_size, 1, StaticCapacity, max_size(),
+														   _rowBytes), std::forward<Us>(values)...);
+	}
+	else
+	{
+		_constructRow(_columns, _size, _Indices(), std::forward<Us>(values)...);
+		++_size;
+	}
+	return back();
+}
+
+VLSOA_TEMPLATE
+template<class... Us>
+typename VLSOA_CLASS::iterator VLSOA_CLASS::emplace(const_iterator position, Us&&... values)
+{
+	std::size_t index = position.index();
+	emplace_back(std::forward<Us>(values)...);
+	std::apply([&](Ts*... column)
+			   {
+				   (std::rotate(column + index, column + _size - 1, column + _size), ...);
+			   }, _columns);
+	return begin() + index;
+}
+
+VLSOA_TEMPLATE
+typename VLSOA_CLASS::iterator VLSOA_CLASS::erase(const_iterator first, const_iterator last)
+{
+	std::size_t index = first.index(), count = last - first;
+	if (count > 0)
+	{
+		std::apply([&](Ts*... column)
+				   {
+					   (std::move(column + index + count, column + _size, column + index), ...);
+				   }, _columns);
+		_destroyRows(_columns, _size - count, _size);
+		_size -= count;
+		_demote();
+	}
+	return begin() + index;
+}
+
+VLSOA_TEMPLATE
+void VLSOA_CLASS::swap(VLSoAVector &other)
+{
+	if (&other == this)
+	{
+		return;
+	}
+	// The moves carry the allocators along as far as they propagate on move assignment.
+	VLSoAVector rows(std::move(other));
+	other = std::move(*this);
+	*this = std::move(rows);
+}
+
+VLSOA_TEMPLATE
+bool VLSOA_CLASS::operator==(const VLSoAVector &other) const
+{
+	if (_size != other._size)
+	{
+		return false;
+	}
+	return _equalRows(other, _Indices());
+}
+
+/**
+ * Swap the rows of the vectors.
+ * @param first
+ * @param second
+ */
+VLSOA_TEMPLATE
+void swap(VLSOA_CLASS &first, VLSOA_CLASS &second)
+{
+	first.swap(second);
+}
+
+#undef VLSOA_CLASS
+#undef VLSOA_TEMPLATE
+
+#endif // VLSOA_VECTOR_HPP
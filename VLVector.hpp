@@ -1,409 +1,2576 @@
-/**
- * @author Eli Fivelzon, eli.fivelzon@mail.huji.ac.il
- */
-#ifndef VLVECTOR_HPP
-#define VLVECTOR_HPP
-#include <cstddef>
-#include <algorithm>
-#include <cmath>
-#include <stdexcept>
-
-/**
- * Default static capacity in template.
- */
-#define DEFAULT_STATIC_CAPACITY 16
-
-/**
- * The growth rate of the memory if needed.
- */
-#define GROWTH_FACTOR (3.0 / 2.0)
-
-/**
- * Error message for execption in case of out of range index access.
- */
-#define OUT_OF_RANGE_ERR_MSG "Index out of range."
-
-/**
- * @class VLVector: A generic container similar to std::vector in interface
- * but manage smartly between stack and heap memory.
- * As long as stack memory is enough, it will be used, then if needed
- * it will appropriately to GROWTH_FACTOR, and if memory is less than
- * stack capacity, the stack will be used again.
- * @tparam T: the type of stored data.
- * @tparam StaticCapacity: The size of stack mem.
- */
-template<class T, std::size_t StaticCapacity = DEFAULT_STATIC_CAPACITY>
-class VLVector
-{
-private:
-	T _staticMem[StaticCapacity];
-	T* _data;
-	std::size_t _size, _capacity;
-
-	/**
-	 * Copy all member fields smartly from other to this.
-	 * Old members of this need to be taken care before.
-	 * @param other
-	 */
-	void _copyMembers(const VLVector &other);
-
-	/**
-	 * Calculate new capacity based on CAPc formula for current size + additional size.
-	 * @param additionalSize: The num of elements that need to be added.
-	 * @return
-	 */
-	std::size_t _cap(std::size_t additionalSize = 1);
-
-	/**
-	 * Push some elements somewhere in the vector while making sure to resize mem if needed.
-	 * This is done in one function to avoid redundant copying in case of need to copy
-	 * to new memory and then to move some of the data to make space for new elements.
-	 * Shift elements (if there are) from pos to the right by size, then call pushFunc.
-	 * @tparam PushFunc: The type of insertion function.
-	 * @param pos: The position in which to push the elements (will be inserted before pos).
-	 * if pos == end then no shifting will take place.
-	 * @param numOfElements: The number of new inserted elements.
-	 * @param pushElements: A function that takes no args an will perform the insertion
-	 * of new elements.
-	 */
-	template<class PushFunc>
-	void _pushAt(const T *pos, std::size_t numOfElements, PushFunc pushElements);
-public:
-	/**
-	 * @typedef iterator: def T* as iterator since it satisfies all requirements
-	 * for random access iterator.
-	 */
-	typedef T* iterator;
-
-	/**
-	 * @typedef const_iterator: def const T* as const_iterator since
-	 * it satisfies all requirements from const random access iterator.
-	 */
-	typedef const T*  const_iterator;
-
-	/**
-	 * Insert elements in the range [first, last) before pos.
-	 * @tparam InputIterator: Type of first, last, must be at least input iterator.
-	 * @param pos:
-	 * @param first
-	 * @param last:
-	 * @return: Iterator to the first element inserted, or pos if no elements
-	 * were inserted.
-	 */
-	template<class InputIterator>
-	iterator insert(const_iterator pos, InputIterator first, InputIterator last);
-
-	/**
-	 * Default constructor, create an empty VLVector.
-	 */
-	VLVector(): _data(_staticMem), _size(0), _capacity(StaticCapacity) {}
-
-	/**
-	 * Copy constructor. Create a new VLVector identical to other.
-	 * @param other
-	 */
-	VLVector(VLVector& other): VLVector() {_copyMembers(other); }
-
-	/**
-	 * Construtor from another range. Has the same effect as creating an empty VLVector,
-	 * then performing insert(begin, first, last).
-	 * @tparam InputIterator: Type of the input iterator to copy values from.
-	 * @param first
-	 * @param last
-	 */
-	template<class InputIterator>
-	VLVector(InputIterator first, InputIterator last): VLVector() {insert(begin(), first, last); }
-
-	/**
-	 * Destructor. Free memory if needed.
-	 */
-	~VLVector();
-
-	/**
-	 * @return number of elements in VLVec.
-	 */
-	std::size_t size() const { return _size; }
-
-	/**
-	 * @return true if empty, false otherwise.
-	 */
-	bool empty() const { return _size == 0; }
-
-	/**
-	 * @return numer of elements that can be stored in current mem.
-	 */
-	std::size_t capacity() const { return _capacity; }
-
-	/**
-	 * Get value at idx with bound checking.
-	 * @param index
-	 * @return
-	 */
-	T& at(std::size_t index);
-
-	/**
- * Get value at idx with bound checking for const.
- * @param index
- * @return
- */
-	const T& at(std::size_t index) const;
-
-	/**
-	 * Insert value before pos.
-	 * @param pos
-	 * @param value
-	 * @return Iterator pointing to the newly inserted value.
-	 */
-	iterator insert(const_iterator pos, const T& value);
-
-	/**
-	 * push value in the end of vector.
-	 * @param value
-	 */
-	void push_back(const T& value) {_pushAt(cend(), 1, [&]() { _data[_size] = value; }); }
-
-	/**
-	 * Remove last value from vector.
-	 */
-	void pop_back() { erase(cend() -  1); }
-
-	/**
-	 * Erase elements in the range [first, last)
-	 * @param first
-	 * @param last
-	 * @return Iterator pointing to the element after the last removed one.
-	 * if first == last,return first.
-	 */
-	iterator erase(const_iterator first, const_iterator last);
-
-	/**
-	 * erase element at pos.
-	 * @param pos
-	 * @return: Iterator pointing after the removed element.
-	 */
-	iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
-
-	/**
-	 * Remove all elements from vec.
-	 */
-	void clear();
-
-	/**
-	 * @return A pointer to the memory containing the data.
-	 */
-	T* data() { return _data; }
-
-
-	/**
-	 * @return A const pointer to the memory containing the data (const).
-	 */
-	const T* data() const { return _data; }
-
-	/**
-	 * Assignment operator
-	 * @param other
-	 * @return : this after assigment.
-	 */
-	VLVector& operator=(const VLVector& other);
-
-	/**
-	 * Access at idx [non-const], no bound checking.
-	 * @param idx
-	 * @return Value at idx by ref.
-	 */
-	T& operator[](std::size_t idx) { return _data[idx]; }
-
-	/**
- * Access at idx [const], no bound checking.
- * @param idx
- * @return Value at idx by cosnt ref.
- */
-	const T& operator[](std::size_t idx) const { return _data[idx]; }
-
-	/**
-	 * @param other
-	 * @return true if this == other elementwise.
-	 */
-	bool operator==(const VLVector& other) const;
-
-	/**
-	 * @param other
-	 * @return negation of operator==.
-	 */
-	bool operator!=(const VLVector& other) const { return !operator=(other); }
-
-	/**
-	 * @return iterator pointing to first element.
-	 */
-	iterator begin() { return _data; }
-
-	/**
-	 * @return iterator pointing after last element.
-	 */
-	iterator end() { return _data + _size; }
-
-	/**
-	 * @return const iterator pointing to first element for const vec.
-	 */
-	const_iterator begin() const { return _data; }
-
-	/**
- * @return const iterator pointing after the last element for const vec.
- */
-	const_iterator end() const { return _data + _size; }
-
-	/**
-	 * @return const iterator pointing to first element.
-	 */
-	const_iterator cbegin() const { return _data; }
-
-	/**
-	 * @return const iterator pointing after last element.
-	 */
-	const_iterator cend() const  { return _data + _size; }
-
-};
-
-template<class T, std::size_t StaticCapacity>
-T &VLVector<T, StaticCapacity>::at(std::size_t index)
-{
-	if (index >= _size)
-	{
-		throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
-	}
-	return _data[index];
-}
-
-template<class T, std::size_t StaticCapacity>
-const T &VLVector<T, StaticCapacity>::at(std::size_t index) const
-{
-	if (index >= _size)
-	{
-		throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
-	}
-	return _data[index];
-}
-
-template<class T, std::size_t StaticCapacity>
-bool VLVector<T, StaticCapacity>::operator==(const VLVector &other) const
-{
-	return end() - begin() == other.end() - other.begin()
-			&& std::equal(begin(), end(), other.begin());
-}
-
-template<class T, std::size_t StaticCapacity>
-std::size_t VLVector<T, StaticCapacity>::_cap(std::size_t additionalSize)
-{
-	return _size + additionalSize <= StaticCapacity?
-	StaticCapacity: std::floor(GROWTH_FACTOR * (_size + additionalSize));
-
-}
-
-template<class T, std::size_t StaticCapacity>
-template<class InputIterator>
-typename VLVector<T, StaticCapacity>::iterator
-VLVector<T, StaticCapacity>::insert(VLVector::const_iterator pos, InputIterator first,
-									InputIterator last)
-{
-	std::size_t numOfElements = std::distance(first, last);
-	std::size_t posIdx = pos - begin();
-	auto pushFunc = [&]() {std::copy(first, last, _data + posIdx); };
-	// Push the elements by using pushFunc after rest will be shifted right.
-	_pushAt(pos, numOfElements, pushFunc);
-	return begin() + posIdx; // Iterator to the first inserted element.
-}
-
-template<class T, std::size_t StaticCapacity>
-typename VLVector<T, StaticCapacity>::iterator
-VLVector<T, StaticCapacity>::erase(VLVector::const_iterator first, VLVector::const_iterator last)
-{
-	T* oldMem = nullptr;
-	const_iterator initEnd = cend();
-	std::size_t toRemoveSize = last - first, firstIdx = first - begin();
-	if (_capacity > StaticCapacity && _size - toRemoveSize <= StaticCapacity)
-	{
-		std::copy(cbegin(), first, _staticMem);
-		oldMem = _data;
-		_data = _staticMem;
-		_capacity = StaticCapacity;
-	}
-	std::copy(last, initEnd, begin() + firstIdx);
-	_size -= toRemoveSize;
-	delete[] oldMem;
-	return begin() + firstIdx;
-}
-
-template<class T, std::size_t StaticCapacity>
-void VLVector<T, StaticCapacity>::clear()
-{
-	erase(begin(), end());
-}
-
-template<class T, std::size_t StaticCapacity>
-VLVector<T, StaticCapacity>& VLVector<T, StaticCapacity>::operator=(const VLVector &other)
-{
-	if (&other == this)
-	{
-		return *this;
-	}
-	if (_capacity > StaticCapacity)
-	{
-		delete[] _data;
-	}
-	_copyMembers(other);
-	return *this;
-}
-
-template<class T, std::size_t StaticCapacity>
-void VLVector<T, StaticCapacity>::_copyMembers(const VLVector &other)
-{
-	if (other._capacity > StaticCapacity)
-	{
-		_data = new T[other._capacity];
-	}
-	_capacity = other._capacity;
-	std::copy(other.begin(), other.end(), begin());
-	_size = other._size;
-}
-
-template<class T, std::size_t StaticCapacity>
-template<class PushFunc>
-void VLVector<T, StaticCapacity>::_pushAt(const T *pos, std::size_t numOfElements, PushFunc
-										  pushElements)
-{
-	T* oldMem = nullptr;
-	const_iterator initialEnd = end();
-	if (_size + numOfElements > _capacity) // Reallocate if needed and copy [begin, first).
-	{
-		T* newMem = new T[_cap(numOfElements)];
-		oldMem = _capacity <= StaticCapacity? nullptr: _data;
-		_capacity = _cap(numOfElements);
-		std::copy(cbegin(), pos, newMem);
-		_data = newMem;
-	}
-	std::copy_backward(pos, initialEnd, end() + numOfElements); // Move elements by numOfElements.
-	pushElements();
-	_size += numOfElements;
-	delete[] oldMem;
-
-}
-
-template<class T, std::size_t StaticCapacity>
-typename VLVector<T, StaticCapacity>::iterator
-        VLVector<T, StaticCapacity>::insert(VLVector::const_iterator pos, const T &value)
-{
-	std::size_t idx = pos - begin();
-	_pushAt(pos, 1, [&]() {_data[idx] = value; });
-	return begin() + idx;
-}
-
-template<class T, std::size_t StaticCapacity>
-VLVector<T, StaticCapacity>::~VLVector()
-{
-	if (_capacity > StaticCapacity)
-	{
-		delete[] _data;
-	}
-}
-
-#endif // VLVECTOR_HPP
+/**
+ * @author Eli Fivelzon, eli.fivelzon@mail.huji.ac.il
+ */
+#ifndef VLVECTOR_HPP
+#define VLVECTOR_HPP
+#include <cstddef>
+#include <algorithm>
+#if __cplusplus > 201703L
+#include <compare>
+#endif
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#if __has_include(<span>)
+#include <span>
+#endif
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#ifdef VLVECTOR_ENABLE_STATS
+#include "VLVectorStats.hpp"
+/**
+ * Run statement only when instrumentation is enabled, see VLVectorStats.hpp.
+ */
+#define VLVECTOR_STAT(statement) statement
+#else
+#define VLVECTOR_STAT(statement)
+#endif
+#if defined(VLVECTOR_ENABLE_STATS) && defined(VLVECTOR_STATS_LOCATIONS)
+/**
+ * Extra constructor parameter capturing the construction site, and what the constructors
+ * do with it, see VLVectorStats.hpp.
+ */
+#define VLVECTOR_LOCATION_PARAM , std::source_location location = std::source_location::current()
+#define VLVECTOR_LOCATION_ARG , location
+#define VLVECTOR_LOCATION_INIT _objectStats.setCounters(_siteStats(location));
+#else
+#define VLVECTOR_LOCATION_PARAM
+#define VLVECTOR_LOCATION_ARG
+#define VLVECTOR_LOCATION_INIT
+#endif
+
+/**
+ * Default static capacity in template.
+ */
+#define DEFAULT_STATIC_CAPACITY 16
+
+/**
+ * Default alignment of VLAlignedVector: a cache line, which also covers AVX-512 loads.
+ */
+#define CACHE_LINE_SIZE 64
+
+/**
+ * Error message for execption in case of out of range index access.
+ */
+#define OUT_OF_RANGE_ERR_MSG "Index out of range."
+
+/**
+ * Error message for exception in case the size would not fit in SizeType.
+ */
+#define LENGTH_ERR_MSG "Size exceeds max_size()."
+
+#if defined(__cpp_lib_constexpr_dynamic_alloc) && !defined(VLVECTOR_ENABLE_STATS)
+/**
+ * With C++20's constexpr allocation VLVector is usable in constant evaluation, e.g. to build a
+ * lookup table into a constexpr or constinit variable instead of a static initializer. Not with
+ * instrumentation, whose counters are static objects.
+ */
+#define VLVECTOR_HAS_CONSTEXPR
+#define VLVECTOR_CONSTEXPR constexpr
+#else
+#define VLVECTOR_CONSTEXPR
+#endif
+
+namespace vl_detail
+{
+/**
+ * @return true during constant evaluation, where memcpy, memmove, realloc and placement new
+ * can't be used.
+ */
+constexpr bool constantEvaluated() noexcept
+{
+#ifdef VLVECTOR_HAS_CONSTEXPR
+	return std::is_constant_evaluated();
+#else
+	return false;
+#endif
+}
+
+/**
+ * A constant may not hold uninitialized objects, so during constant evaluation the slots of a
+ * memory which hold no element hold a value initialized placeholder instead, which
+ * constructing an element replaces and destroying it brings back.
+ * Construct placeholders in [first, last) during constant evaluation, do nothing otherwise.
+ * @param first
+ * @param last
+ */
+template<class T>
+VLVECTOR_CONSTEXPR void startPlaceholders(T* first, T* last)
+{
+	for (; constantEvaluated() && first != last; ++first)
+	{
+#ifdef VLVECTOR_HAS_CONSTEXPR
+		if constexpr (std::is_default_constructible<T>::value)
+		{
+			std::construct_at(first);
+		}
+#endif
+	}
+}
+
+/**
+ * Destroy the placeholders in [first, last) during constant evaluation, do nothing otherwise.
+ * @param first
+ * @param last
+ */
+template<class T>
+VLVECTOR_CONSTEXPR void endPlaceholders(T* first, T* last)
+{
+	for (; constantEvaluated() && first != last; ++first)
+	{
+		if constexpr (std::is_default_constructible<T>::value)
+		{
+			first->~T();
+		}
+	}
+}
+} // namespace vl_detail
+
+/**
+ * @struct VLRatioGrowth: Growth policy, grow the memory to floor(required * Num / Den).
+ * A growth policy provides grow(required, elementSize): the capacity to allocate when
+ * required elements (of elementSize bytes) no longer fit. VLVector never allocates less
+ * than required, whatever the policy returns.
+ * @tparam Num
+ * @tparam Den
+ */
+template<std::size_t Num = 3, std::size_t Den = 2>
+struct VLRatioGrowth
+{
+	static_assert(Den != 0 && Num >= Den, "Growth ratio must be at least 1.");
+
+	static constexpr std::size_t grow(std::size_t required, std::size_t)
+	{
+		// Same as required * Num / Den, without overflowing on the multiplication.
+		return required / Den * Num + required % Den * Num / Den;
+	}
+};
+
+/**
+ * @struct VLPowerOfTwoGrowth: Growth policy, grow the memory to the next power of two.
+ */
+struct VLPowerOfTwoGrowth
+{
+	static constexpr std::size_t grow(std::size_t required, std::size_t)
+	{
+		std::size_t capacity = 1;
+		while (capacity < required && capacity << 1 != 0)
+		{
+			capacity <<= 1;
+		}
+		return capacity < required? required: capacity;
+	}
+};
+
+/**
+ * @struct VLSizeClassGrowth: Growth policy, grow by Base, then round the block up to the
+ * allocation size classes used by jemalloc/tcmalloc style allocators (16 bytes spacing up
+ * to 128 bytes, then 4 classes per power of two), so the slack the allocator would hand out
+ * anyway becomes usable capacity.
+ * @tparam Base: The growth policy to apply before rounding.
+ */
+template<class Base = VLRatioGrowth<>>
+struct VLSizeClassGrowth
+{
+	static constexpr std::size_t sizeClass(std::size_t bytes)
+	{
+		if (bytes <= 128)
+		{
+			return (bytes + 15) & ~std::size_t(15);
+		}
+		std::size_t log = 0;
+		for (std::size_t rest = bytes - 1; rest > 1; rest >>= 1)
+		{
+			++log;
+		}
+		std::size_t spacing = std::size_t(1) << (log - 2);
+		return (bytes + spacing - 1) & ~(spacing - 1);
+	}
+
+	static constexpr std::size_t grow(std::size_t required, std::size_t elementSize)
+	{
+		std::size_t capacity = Base::grow(required, elementSize);
+		if (elementSize == 0 || capacity > std::size_t(-1) / 2 / elementSize)
+		{
+			return capacity;
+		}
+		return sizeClass(capacity * elementSize) / elementSize;
+	}
+};
+
+/**
+ * @struct VLPaddedGrowth: Growth policy, grow by Base, then round the capacity up to a whole
+ * number of Bytes (when the element size divides Bytes), e.g. a SIMD register, so kernels may
+ * process the tail of data() with full width loads. reserve and shrink_to_fit don't pad.
+ * @tparam Bytes
+ * @tparam Base: The growth policy to apply before rounding.
+ */
+template<std::size_t Bytes, class Base = VLRatioGrowth<>>
+struct VLPaddedGrowth
+{
+	static constexpr std::size_t grow(std::size_t required, std::size_t elementSize)
+	{
+		std::size_t capacity = Base::grow(required, elementSize);
+		std::size_t width = elementSize == 0 || elementSize > Bytes? 1: Bytes / elementSize;
+		if (capacity > std::size_t(-1) - width)
+		{
+			return capacity;
+		}
+		return (capacity + width - 1) / width * width;
+	}
+};
+
+/**
+ * @struct VLDemoteAtCapacity: Demotion policy, move back to the inline storage as soon as
+ * an erase brings the size down to StaticCapacity.
+ * A demotion policy provides:
+ * onErase(newSize, staticCapacity): true if erase should move a heap vector of newSize
+ * elements back to the inline storage.
+ * onShrink: true if shrink_to_fit may move back to the inline storage.
+ */
+struct VLDemoteAtCapacity
+{
+	static constexpr bool onErase(std::size_t newSize, std::size_t staticCapacity)
+	{
+		return newSize <= staticCapacity;
+	}
+
+	static constexpr bool onShrink = true;
+};
+
+/**
+ * @struct VLDemoteAtLowWater: Demotion policy, move back to the inline storage only once
+ * the size drops to StaticCapacity * Num / Den (half by default), so a size oscillating
+ * around StaticCapacity does not reallocate on every crossing.
+ * @tparam Num
+ * @tparam Den
+ */
+template<std::size_t Num = 1, std::size_t Den = 2>
+struct VLDemoteAtLowWater
+{
+	static_assert(Den != 0 && Num <= Den, "Low water mark must be a fraction of capacity.");
+
+	static constexpr bool onErase(std::size_t newSize, std::size_t staticCapacity)
+	{
+		return newSize <= staticCapacity * Num / Den;
+	}
+
+	static constexpr bool onShrink = true;
+};
+
+/**
+ * @struct VLDemoteOnShrink: Demotion policy, erase keeps the heap memory, only an explicit
+ * shrink_to_fit moves back to the inline storage.
+ */
+struct VLDemoteOnShrink
+{
+	static constexpr bool onErase(std::size_t, std::size_t) { return false; }
+
+	static constexpr bool onShrink = true;
+};
+
+/**
+ * @struct VLDemoteNever: Demotion policy, once on the heap the vector stays there
+ * (shrink_to_fit only trims the heap memory) until it is cleared by assignment or moved from.
+ */
+struct VLDemoteNever
+{
+	static constexpr bool onErase(std::size_t, std::size_t) { return false; }
+
+	static constexpr bool onShrink = false;
+};
+
+/**
+ * @struct VLInlineLayout: Layout policy, keeps the inline storage next to a heap pointer, the
+ * size, the capacity and a flag, so size() and capacity() are plain loads and data() picks the
+ * heap pointer or the inline slots by the capacity. It never points into itself, so a constexpr
+ * VLVector is a constant the compiler can read back and place in read only memory.
+ * A layout policy provides Storage<T, StaticCapacity, SizeType, Alignment>, which owns the
+ * inline slots (aligned to Alignment, holding placeholders during constant evaluation, see
+ * vl_detail::startPlaceholders) and tells where the elements are:
+ * data(), size(), capacity(), onHeap(), staticData(), pinned(): the current state.
+ * setSize(size), setPinned(pinned): change one field.
+ * setHeap(mem, capacity): use the heap memory mem from now on.
+ * setInline(): use the inline storage from now on, unpinned.
+ * maxSize: the largest size and capacity it can hold.
+ * A heap memory always has a capacity bigger than StaticCapacity.
+ */
+struct VLInlineLayout
+{
+	template<class T, std::size_t StaticCapacity, class SizeType, std::size_t Alignment>
+	class Storage
+	{
+	private:
+		union
+		{
+			alignas(Alignment) T _staticMem[StaticCapacity];
+		};
+		/**
+		 * The heap memory while onHeap(), nullptr otherwise.
+		 */
+		T* _heapData;
+		SizeType _size, _capacity;
+
+		/**
+		 * Set by reserve: the heap memory was requested explicitly, so erase will not move
+		 * back to the inline storage. Cleared by shrink_to_fit.
+		 */
+		bool _pinned;
+	public:
+		static constexpr std::size_t maxSize = SizeType(-1);
+
+		VLVECTOR_CONSTEXPR Storage(): _heapData(nullptr), _size(0), _capacity(StaticCapacity),
+									  _pinned(false)
+		{
+			vl_detail::startPlaceholders(_staticMem, _staticMem + StaticCapacity);
+		}
+
+		VLVECTOR_CONSTEXPR ~Storage() {}
+
+		Storage(const Storage&) = delete;
+
+		Storage& operator=(const Storage&) = delete;
+
+		VLVECTOR_CONSTEXPR T* data() { return onHeap()? _heapData: staticData(); }
+
+		VLVECTOR_CONSTEXPR const T* data() const { return onHeap()? _heapData: _staticMem; }
+
+		VLVECTOR_CONSTEXPR T* staticData() { return _staticMem; }
+
+		VLVECTOR_CONSTEXPR std::size_t size() const { return _size; }
+
+		VLVECTOR_CONSTEXPR void setSize(std::size_t size) { _size = static_cast<SizeType>(size); }
+
+		VLVECTOR_CONSTEXPR std::size_t capacity() const { return _capacity; }
+
+		VLVECTOR_CONSTEXPR bool onHeap() const { return _capacity > StaticCapacity; }
+
+		VLVECTOR_CONSTEXPR bool pinned() const { return _pinned; }
+
+		VLVECTOR_CONSTEXPR void setPinned(bool pinned) { _pinned = pinned; }
+
+		VLVECTOR_CONSTEXPR void setHeap(T* mem, std::size_t capacity)
+		{
+			_heapData = mem;
+			_capacity = static_cast<SizeType>(capacity);
+		}
+
+		VLVECTOR_CONSTEXPR void setInline()
+		{
+			_heapData = nullptr;
+			_capacity = StaticCapacity;
+			_pinned = false;
+		}
+	};
+};
+
+/**
+ * @struct VLCompactLayout: Layout policy, overlays the heap pointer and capacity with the
+ * inline slots (which are unused while on the heap) and packs the size with the heap and
+ * pinned flags into one word. A VLVector then takes one word plus its inline slots (at least
+ * two words of them), data() is a select between two addresses and size() a shift.
+ * Since a move back to the inline storage overwrites the heap pointer, VLVector saves it first.
+ */
+struct VLCompactLayout
+{
+	template<class T, std::size_t StaticCapacity, class SizeType, std::size_t Alignment>
+	class Storage
+	{
+	private:
+		/**
+		 * Flag bits in the low bits of _sizeAndFlags, the size is stored above them.
+		 */
+		static constexpr SizeType _heapBit = 1, _pinnedBit = 2, _flagBits = 2;
+
+		struct Heap
+		{
+			T* data;
+			SizeType capacity;
+		};
+
+		union
+		{
+			alignas(Alignment) T _staticMem[StaticCapacity];
+			Heap _heap;
+		};
+		SizeType _sizeAndFlags;
+	public:
+		static constexpr std::size_t maxSize = SizeType(-1) >> _flagBits;
+
+		VLVECTOR_CONSTEXPR Storage(): _sizeAndFlags(0)
+		{
+			vl_detail::startPlaceholders(_staticMem, _staticMem + StaticCapacity);
+		}
+
+		VLVECTOR_CONSTEXPR ~Storage() {}
+
+		Storage(const Storage&) = delete;
+
+		Storage& operator=(const Storage&) = delete;
+
+		VLVECTOR_CONSTEXPR T* data() { return onHeap()? _heap.data: staticData(); }
+
+		VLVECTOR_CONSTEXPR const T* data() const { return onHeap()? _heap.data: _staticMem; }
+
+		VLVECTOR_CONSTEXPR T* staticData() { return _staticMem; }
+
+		VLVECTOR_CONSTEXPR std::size_t size() const { return _sizeAndFlags >> _flagBits; }
+
+		VLVECTOR_CONSTEXPR void setSize(std::size_t size)
+		{
+			_sizeAndFlags = static_cast<SizeType>(size << _flagBits
+												  | (_sizeAndFlags & (_heapBit | _pinnedBit)));
+		}
+
+		VLVECTOR_CONSTEXPR std::size_t capacity() const
+		{
+			return onHeap()? _heap.capacity: StaticCapacity;
+		}
+
+		VLVECTOR_CONSTEXPR bool onHeap() const { return _sizeAndFlags & _heapBit; }
+
+		VLVECTOR_CONSTEXPR bool pinned() const { return _sizeAndFlags & _pinnedBit; }
+
+		VLVECTOR_CONSTEXPR void setPinned(bool pinned)
+		{
+			_sizeAndFlags = static_cast<SizeType>(pinned? _sizeAndFlags | _pinnedBit:
+												  _sizeAndFlags & ~_pinnedBit);
+		}
+
+		VLVECTOR_CONSTEXPR void setHeap(T* mem, std::size_t capacity)
+		{
+			_heap = Heap{mem, static_cast<SizeType>(capacity)};
+			_sizeAndFlags |= _heapBit;
+		}
+
+		VLVECTOR_CONSTEXPR void setInline()
+		{
+			_sizeAndFlags = static_cast<SizeType>(_sizeAndFlags & ~(_heapBit | _pinnedBit));
+		}
+	};
+};
+
+/**
+ * @struct VLIsTriviallyRelocatable: Customization point, true if moving a T to a new address
+ * and ending the old object's lifetime can be done by copying its bytes. VLVector then
+ * grows, shifts and demotes such elements with memcpy/memmove instead of move constructor
+ * and destructor pairs. Trivially copyable types are relocatable by default, other types
+ * may opt in by specializing:
+ * template<> struct VLIsTriviallyRelocatable<MyRecord>: std::true_type {};
+ * @tparam T
+ */
+template<class T>
+struct VLIsTriviallyRelocatable: std::is_trivially_copyable<T> {};
+
+template<class T>
+struct VLIsTriviallyRelocatable<std::unique_ptr<T>>: std::true_type {};
+
+template<class T>
+struct VLIsTriviallyRelocatable<std::shared_ptr<T>>: std::true_type {};
+
+/**
+ * @struct VLMallocAllocator: Allocator on top of malloc/realloc/free. Besides the standard
+ * allocator members it provides reallocate(mem, oldCapacity, newCapacity), which VLVector
+ * uses to grow or trim the heap memory of trivially relocatable elements without copying
+ * them when the block can be extended in place. For large blocks glibc services realloc
+ * with mremap, so even a moving reallocation only remaps pages.
+ * Any allocator may provide such a reallocate: it returns the (possibly moved) block holding
+ * the first min(oldCapacity, newCapacity) elements' bytes, or throws leaving mem untouched.
+ * @tparam T
+ */
+template<class T>
+struct VLMallocAllocator
+{
+	static_assert(alignof(T) <= alignof(std::max_align_t), "malloc can't align T.");
+
+	typedef T value_type;
+	typedef std::true_type is_always_equal;
+
+	/**
+	 * Alignment of the returned memories, see VLVector's Alignment.
+	 */
+	static constexpr std::size_t alignment = alignof(std::max_align_t);
+
+	VLMallocAllocator() = default;
+
+	template<class U>
+	VLMallocAllocator(const VLMallocAllocator<U>&) noexcept {}
+
+	T* allocate(std::size_t capacity) { return reallocate(nullptr, 0, capacity); }
+
+	void deallocate(T* mem, std::size_t) noexcept { std::free(mem); }
+
+	T* reallocate(T* mem, std::size_t, std::size_t newCapacity)
+	{
+		void* newMem = newCapacity <= std::size_t(-1) / sizeof(T)?
+					   std::realloc(static_cast<void*>(mem), newCapacity * sizeof(T)): nullptr;
+		if (newMem == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+		return static_cast<T*>(newMem);
+	}
+
+	template<class U>
+	bool operator==(const VLMallocAllocator<U>&) const noexcept { return true; }
+
+	template<class U>
+	bool operator!=(const VLMallocAllocator<U>&) const noexcept { return false; }
+};
+
+/**
+ * @struct VLAlignedAllocator: Allocator returning memories aligned to Alignment, through the
+ * aligned operator new.
+ * @tparam T
+ * @tparam Alignment: A power of two, at least alignof(T).
+ */
+template<class T, std::size_t Alignment>
+struct VLAlignedAllocator
+{
+	static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0,
+				  "Alignment must be a power of two of at least alignof(T).");
+
+	typedef T value_type;
+	typedef std::true_type is_always_equal;
+
+	static constexpr std::size_t alignment = Alignment;
+
+	template<class U>
+	struct rebind
+	{
+		typedef VLAlignedAllocator<U, Alignment> other;
+	};
+
+	VLAlignedAllocator() = default;
+
+	template<class U>
+	VLAlignedAllocator(const VLAlignedAllocator<U, Alignment>&) noexcept {}
+
+	T* allocate(std::size_t capacity)
+	{
+		if (capacity > std::size_t(-1) / sizeof(T))
+		{
+			throw std::bad_alloc();
+		}
+		return static_cast<T*>(::operator new(capacity * sizeof(T), std::align_val_t(Alignment)));
+	}
+
+	void deallocate(T* mem, std::size_t capacity) noexcept
+	{
+		::operator delete(mem, capacity * sizeof(T), std::align_val_t(Alignment));
+	}
+
+	template<class U>
+	bool operator==(const VLAlignedAllocator<U, Alignment>&) const noexcept { return true; }
+
+	template<class U>
+	bool operator!=(const VLAlignedAllocator<U, Alignment>&) const noexcept { return false; }
+};
+
+namespace vl_detail
+{
+/**
+ * @struct AllocatorAlignment: The alignment of the memories Allocator returns: its alignment
+ * member if it has one, what operator new guarantees for std::allocator and alignof(T)
+ * otherwise.
+ */
+template<class Allocator, class = void>
+struct AllocatorAlignment: std::integral_constant<std::size_t,
+		alignof(typename Allocator::value_type)> {};
+
+template<class T>
+struct AllocatorAlignment<std::allocator<T>>: std::integral_constant<std::size_t,
+		std::max(alignof(T), std::size_t(__STDCPP_DEFAULT_NEW_ALIGNMENT__))> {};
+
+template<class Allocator>
+struct AllocatorAlignment<Allocator, std::void_t<decltype(Allocator::alignment)>>:
+		std::integral_constant<std::size_t, Allocator::alignment> {};
+
+/**
+ * The growth rule of VLVector (and its companion containers): the capacity to hold size +
+ * additionalSize elements, staticCapacity as long as they fit inline, otherwise what
+ * GrowthPolicy returns, at least the required size and at most maxSize.
+ * Throws std::length_error if the new size would exceed maxSize.
+ * @param size
+ * @param additionalSize
+ * @param staticCapacity
+ * @param maxSize
+ * @param elementSize: The bytes of one element, passed on to GrowthPolicy.
+ * @return
+ */
+template<class GrowthPolicy>
+VLVECTOR_CONSTEXPR std::size_t growCapacity(std::size_t size, std::size_t additionalSize,
+											std::size_t staticCapacity, std::size_t maxSize,
+											std::size_t elementSize)
+{
+	if (additionalSize > maxSize - size)
+	{
+		throw std::length_error(LENGTH_ERR_MSG);
+	}
+	std::size_t required = size + additionalSize;
+	if (required <= staticCapacity)
+	{
+		return staticCapacity;
+	}
+	std::size_t grown = std::min(GrowthPolicy::grow(required, elementSize), maxSize);
+	return grown < required? required: grown;
+}
+
+/**
+ * @struct HasReallocate: True if Allocator provides reallocate(mem, oldCapacity, newCapacity),
+ * see VLMallocAllocator.
+ */
+template<class Allocator, class = void>
+struct HasReallocate: std::false_type {};
+
+template<class Allocator>
+struct HasReallocate<Allocator, std::void_t<decltype(std::declval<Allocator&>().reallocate(
+		std::declval<typename Allocator::value_type*>(), std::size_t(), std::size_t()))>>:
+		std::true_type {};
+
+/**
+ * @struct HasCopyBytes: True if Allocator provides copy_bytes(dest, src, bytes), which VLVector
+ * uses instead of memcpy for the bitwise copies between memories which don't overlap, see
+ * VLHugePageAllocator.
+ */
+template<class Allocator, class = void>
+struct HasCopyBytes: std::false_type {};
+
+template<class Allocator>
+struct HasCopyBytes<Allocator, std::void_t<decltype(std::declval<Allocator&>().copy_bytes(
+		std::declval<void*>(), std::declval<const void*>(), std::size_t()))>>: std::true_type {};
+
+/**
+ * @struct HasCustomConstruct: True if Allocator has its own construct or destroy for T,
+ * which bitwise copies would skip.
+ */
+template<class Allocator, class T, class = void>
+struct HasCustomConstruct: std::false_type {};
+
+template<class Allocator, class T>
+struct HasCustomConstruct<Allocator, T, std::void_t<decltype(
+		std::declval<Allocator&>().construct(std::declval<T*>(), std::declval<const T&>()))>>:
+		std::true_type {};
+
+template<class Allocator, class T, class = void>
+struct HasCustomDestroy: std::false_type {};
+
+template<class Allocator, class T>
+struct HasCustomDestroy<Allocator, T, std::void_t<decltype(
+		std::declval<Allocator&>().destroy(std::declval<T*>()))>>: std::true_type {};
+
+/**
+ * @struct UsesDefaultConstruct: True if Allocator constructs and destroys T exactly like
+ * placement new and a destructor call.
+ */
+template<class Allocator, class T>
+struct UsesDefaultConstruct: std::disjunction<std::is_same<Allocator, std::allocator<T>>,
+		std::conjunction<std::negation<HasCustomConstruct<Allocator, T>>,
+						 std::negation<HasCustomDestroy<Allocator, T>>>> {};
+
+/**
+ * @class AllocatorHolder: Stores a container's allocator. An empty allocator is kept as a
+ * base class so it takes no space in the container.
+ * @tparam Allocator
+ */
+template<class Allocator, bool IsEmpty = std::is_empty<Allocator>::value
+										 && !std::is_final<Allocator>::value>
+class AllocatorHolder: private Allocator
+{
+public:
+	VLVECTOR_CONSTEXPR explicit AllocatorHolder(const Allocator& alloc): Allocator(alloc) {}
+
+	VLVECTOR_CONSTEXPR Allocator& allocator() { return *this; }
+
+	VLVECTOR_CONSTEXPR const Allocator& allocator() const { return *this; }
+};
+
+template<class Allocator>
+class AllocatorHolder<Allocator, false>
+{
+private:
+	Allocator _allocator;
+public:
+	VLVECTOR_CONSTEXPR explicit AllocatorHolder(const Allocator& alloc): _allocator(alloc) {}
+
+	VLVECTOR_CONSTEXPR Allocator& allocator() { return _allocator; }
+
+	VLVECTOR_CONSTEXPR const Allocator& allocator() const { return _allocator; }
+};
+
+/**
+ * @struct IsByteLike: True for the unsigned one byte types, for which memcmp order is
+ * the same as value order.
+ */
+template<class T>
+struct IsByteLike: std::integral_constant<bool, std::is_same<T, unsigned char>::value
+		|| std::is_same<T, std::byte>::value
+		|| (std::is_same<T, char>::value && !std::is_signed<char>::value)> {};
+
+/**
+ * Elements checked per block in findArithmetic: a cache line.
+ */
+template<class T>
+constexpr std::size_t findBlock = 64 / sizeof(T) > 0? 64 / sizeof(T): 1;
+
+/**
+ * std::find for arithmetic types. Whole blocks are tested without an early exit so the
+ * compiler can vectorize the comparisons, only the block holding the match is rescanned.
+ * @param first
+ * @param last
+ * @param value
+ * @return Pointer to the first element equal to value, or last.
+ */
+template<class T>
+VLVECTOR_CONSTEXPR const T* findArithmetic(const T* first, const T* last, T value)
+{
+	while (static_cast<std::size_t>(last - first) >= findBlock<T>)
+	{
+		unsigned char found = 0;
+		for (std::size_t i = 0; i < findBlock<T>; ++i)
+		{
+			found |= first[i] == value;
+		}
+		if (found)
+		{
+			break;
+		}
+		first += findBlock<T>;
+	}
+	while (first != last && !(*first == value))
+	{
+		++first;
+	}
+	return first;
+}
+
+/**
+ * std::count for arithmetic types, written as a branch free sum so it vectorizes.
+ * @param first
+ * @param last
+ * @param value
+ * @return Number of elements equal to value.
+ */
+template<class T>
+VLVECTOR_CONSTEXPR std::size_t countArithmetic(const T* first, const T* last, T value)
+{
+	std::size_t count = 0;
+	for (; first != last; ++first)
+	{
+		count += *first == value;
+	}
+	return count;
+}
+} // namespace vl_detail
+
+/**
+ * @class VLVector: A generic container similar to std::vector in interface
+ * but manage smartly between stack and heap memory.
+ * As long as stack memory is enough, it will be used, then if needed
+ * it will grow appropriately to GrowthPolicy, and if memory is less than
+ * stack capacity, the stack will be used again.
+ * Moves to a new memory build it completely (moving elements whose move is noexcept,
+ * copying the others) before releasing the old one, so they give the strong guarantee.
+ * @tparam T: the type of stored data.
+ * @tparam StaticCapacity: The size of stack mem.
+ * @tparam GrowthPolicy: How much heap memory to allocate when growing, see VLRatioGrowth.
+ * @tparam SizeType: Unsigned type storing the size and capacity, a smaller one makes the
+ * vector smaller but limits max_size().
+ * @tparam Allocator: Allocator for the heap memory and for constructing elements.
+ * @tparam DemotionPolicy: When to move from the heap back to the stack mem,
+ * see VLDemoteAtCapacity.
+ * @tparam Layout: How the inline storage, pointer and size are laid out, see VLInlineLayout.
+ * @tparam Alignment: Alignment of data(), both inline and on the heap (the allocator must
+ * provide it, see VLAlignedAllocator and VLAlignedVector).
+ */
+template<class T, std::size_t StaticCapacity = DEFAULT_STATIC_CAPACITY,
+		 class GrowthPolicy = VLRatioGrowth<>, class SizeType = std::size_t,
+		 class Allocator = std::allocator<T>, class DemotionPolicy = VLDemoteAtCapacity,
+		 class Layout = VLInlineLayout, std::size_t Alignment = alignof(T)>
+class VLVector: private vl_detail::AllocatorHolder<Allocator>
+{
+private:
+	static_assert(std::is_same<typename Allocator::value_type, T>::value,
+				  "Allocator::value_type must be T.");
+
+	static_assert(std::is_unsigned<SizeType>::value, "SizeType must be an unsigned integer.");
+
+	static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0,
+				  "Alignment must be a power of two of at least alignof(T).");
+
+	static_assert(vl_detail::AllocatorAlignment<Allocator>::value >= Alignment,
+				  "Allocator does not align to Alignment, see VLAlignedAllocator.");
+
+	typedef std::allocator_traits<Allocator> _AllocTraits;
+
+	/**
+	 * Copies of T may be done with memcpy.
+	 */
+	static constexpr bool _bitwiseCopy = std::is_trivially_copyable<T>::value
+										 && vl_detail::UsesDefaultConstruct<Allocator, T>::value;
+
+	/**
+	 * Relocations of T may be done with memcpy/memmove.
+	 */
+	static constexpr bool _bitwiseRelocate =
+			VLIsTriviallyRelocatable<T>::value
+			&& vl_detail::UsesDefaultConstruct<Allocator, T>::value;
+
+	/**
+	 * A heap memory may be resized by Allocator::reallocate instead of allocate-copy-free.
+	 */
+	static constexpr bool _canReallocate = _bitwiseRelocate
+										   && vl_detail::HasReallocate<Allocator>::value;
+
+	/**
+	 * Iterator used by the non bitwise _relocate: move if it can't throw, otherwise copy so
+	 * the source stays intact on failure.
+	 */
+	typedef typename std::conditional<!std::is_nothrow_move_constructible<T>::value
+									  && std::is_copy_constructible<T>::value,
+									  const T*, std::move_iterator<T*>>::type _RelocateIterator;
+
+	/**
+	 * Raw inline storage, the element pointer and the size. Only the elements in [0, size())
+	 * are alive, so creating a VLVector costs nothing regardless of StaticCapacity (except
+	 * during constant evaluation, see vl_detail::startPlaceholders).
+	 */
+	typename Layout::template Storage<T, StaticCapacity, SizeType, Alignment> _store;
+
+	static_assert(StaticCapacity < decltype(_store)::maxSize, "StaticCapacity exceeds SizeType.");
+
+#ifdef VLVECTOR_ENABLE_STATS
+	vl_detail::ObjectStats _objectStats{_stats()};
+#endif
+
+	/**
+	 * @return Pointer to the first slot of the inline storage.
+	 */
+	VLVECTOR_CONSTEXPR T* _staticData() { return _store.staticData(); }
+
+	/**
+	 * During constant evaluation, put the placeholders back in the inline slots before the
+	 * vector moves back to them, the compact layout overwrote them with the heap block (which
+	 * must have been saved).
+	 */
+	VLVECTOR_CONSTEXPR void _startInlinePlaceholders()
+	{
+		vl_detail::startPlaceholders(_staticData(), _staticData() + StaticCapacity);
+	}
+
+	VLVECTOR_CONSTEXPR Allocator& _alloc() { return this->allocator(); }
+
+	VLVECTOR_CONSTEXPR const Allocator& _alloc() const { return this->allocator(); }
+
+	/**
+	 * Allocate uninitialized heap memory for capacity elements.
+	 * @param capacity
+	 * @return
+	 */
+	VLVECTOR_CONSTEXPR T* _allocate(std::size_t capacity)
+	{
+		T* mem = _AllocTraits::allocate(_alloc(), capacity);
+		vl_detail::startPlaceholders(mem, mem + capacity);
+		return mem;
+	}
+
+	/**
+	 * Free memory returned by _allocate. No destructors are called.
+	 * @param mem
+	 * @param capacity: The capacity mem was allocated with.
+	 */
+	VLVECTOR_CONSTEXPR void _deallocate(T* mem, std::size_t capacity)
+	{
+		vl_detail::endPlaceholders(mem, mem + capacity);
+		_AllocTraits::deallocate(_alloc(), mem, capacity);
+	}
+
+	/**
+	 * Construct an element from args in an uninitialized slot, through the allocator.
+	 * @param slot
+	 * @param args
+	 */
+	template<class... Args>
+	VLVECTOR_CONSTEXPR void _construct(T* slot, Args&&... args)
+	{
+		_AllocTraits::construct(_alloc(), slot, std::forward<Args>(args)...);
+	}
+
+	/**
+	 * Destroy the elements in [first, last) through the allocator.
+	 * @param first
+	 * @param last
+	 */
+	VLVECTOR_CONSTEXPR void _destroy(T* first, T* last)
+	{
+		for (T* slot = first; slot != last; ++slot)
+		{
+			_AllocTraits::destroy(_alloc(), slot);
+		}
+		vl_detail::startPlaceholders(first, last);
+	}
+
+	/**
+	 * Copy construct [first, last) into the uninitialized memory at dest.
+	 * If a copy throws, the elements already constructed are destroyed.
+	 * @param first
+	 * @param last
+	 * @param dest
+	 * @return Pointer after the last constructed element.
+	 */
+	template<class InputIterator>
+	VLVECTOR_CONSTEXPR T* _uninitializedCopy(InputIterator first, InputIterator last, T* dest);
+
+	/**
+	 * Move construct [first, last) into the uninitialized memory at dest.
+	 * @param first
+	 * @param last
+	 * @param dest
+	 * @return Pointer after the last constructed element.
+	 */
+	VLVECTOR_CONSTEXPR T* _uninitializedMove(T* first, T* last, T* dest)
+	{
+		if constexpr (_bitwiseCopy)
+		{
+			return _uninitializedCopy(static_cast<const T*>(first), static_cast<const T*>(last),
+									  dest);
+		}
+		return _uninitializedCopy(std::make_move_iterator(first), std::make_move_iterator(last),
+								  dest);
+	}
+
+	/**
+	 * memcpy, or Allocator::copy_bytes if it has one.
+	 * @param dest: Must not overlap [src, src + bytes).
+	 * @param src
+	 * @param bytes
+	 */
+	void _copyBytes(void* dest, const void* src, std::size_t bytes)
+	{
+		if constexpr (vl_detail::HasCopyBytes<Allocator>::value)
+		{
+			_alloc().copy_bytes(dest, src, bytes);
+		}
+		else
+		{
+			std::memcpy(dest, src, bytes);
+		}
+	}
+
+	/**
+	 * Move the elements of [first, last) to the uninitialized memory at dest, ending their
+	 * lifetime at the source. Bitwise when T is trivially relocatable (then dest may overlap
+	 * [first, last)), otherwise see _RelocateIterator and dest must not overlap.
+	 * If a construction throws, the source is left as it was (unless T is move only).
+	 * @param first
+	 * @param last
+	 * @param dest
+	 */
+	VLVECTOR_CONSTEXPR void _relocate(T* first, T* last, T* dest);
+
+	/**
+	 * Relocate [first, last) to dest and [secondFirst, secondLast) to secondDest, all or
+	 * nothing: if a construction throws, whatever was constructed at the destinations is
+	 * destroyed and both sources are left as they were (unless T is move only).
+	 * The destinations must not overlap the sources.
+	 * @param first
+	 * @param last
+	 * @param dest
+	 * @param secondFirst
+	 * @param secondLast
+	 * @param secondDest
+	 */
+	VLVECTOR_CONSTEXPR void _relocateParts(T* first, T* last, T* dest, T* secondFirst,
+										   T* secondLast, T* secondDest);
+
+	/**
+	 * Construct count elements from args into the uninitialized memory at dest.
+	 * If a construction throws, the elements already constructed are destroyed.
+	 * @param dest
+	 * @param count
+	 * @param args
+	 */
+	template<class... Args>
+	VLVECTOR_CONSTEXPR void _uninitializedFill(T* dest, std::size_t count, const Args&... args);
+
+	/**
+	 * Default initialize count elements in the uninitialized memory at dest, so trivial
+	 * types are left uninitialized. Allocators with their own construct value initialize.
+	 * If a construction throws, the elements already constructed are destroyed.
+	 * @param dest
+	 * @param count
+	 */
+	VLVECTOR_CONSTEXPR void _uninitializedDefault(T* dest, std::size_t count);
+
+	/**
+	 * Destroy all live elements and free the heap memory if used, leaving this
+	 * empty on the inline storage.
+	 */
+	VLVECTOR_CONSTEXPR void _release();
+
+	/**
+	 * Copy all member fields smartly from other to this.
+	 * This must be empty and on the inline storage before.
+	 * @param other
+	 */
+	VLVECTOR_CONSTEXPR void _copyMembers(const VLVector &other);
+
+	/**
+	 * Move all member fields from other to this, leaving other empty on its inline storage.
+	 * A heap block is taken over as is if the allocators are equal, inline elements
+	 * (or all of them, for unequal allocators) are moved one by one.
+	 * This must be empty and on the inline storage before.
+	 * @param other
+	 */
+	VLVECTOR_CONSTEXPR void _moveMembers(VLVector &other);
+
+	/**
+	 * Move all elements to a memory of exactly newCapacity elements (the inline storage if
+	 * newCapacity is StaticCapacity) and free the old one if needed.
+	 * @param newCapacity: Must be at least size().
+	 */
+	VLVECTOR_CONSTEXPR void _reallocate(std::size_t newCapacity);
+
+	/**
+	 * Resize the heap memory to newCapacity with Allocator::reallocate, if it has one and this
+	 * is on the heap. The block may move, so pointers into it are invalidated.
+	 * @param newCapacity: Must be at least size() and more than StaticCapacity.
+	 * @return true on success, false if the memory has to be reallocated the usual way.
+	 */
+	VLVECTOR_CONSTEXPR bool _tryReallocate(std::size_t newCapacity);
+
+	/**
+	 * @param additionalSize
+	 * @return true if adding additionalSize elements will go through _tryReallocate, that is
+	 * before the new elements are constructed.
+	 */
+	VLVECTOR_CONSTEXPR bool _growsByReallocate(std::size_t additionalSize) const
+	{
+		return _canReallocate && _store.onHeap() && size() + additionalSize > capacity();
+	}
+
+	/**
+	 * Calculate new capacity based on GrowthPolicy for current size + additional size,
+	 * capped at max_size(). Throws std::length_error if the new size would exceed max_size().
+	 * @param additionalSize: The num of elements that need to be added.
+	 * @return
+	 */
+	VLVECTOR_CONSTEXPR std::size_t _cap(std::size_t additionalSize = 1) const;
+
+	/**
+	 * Push some elements somewhere in the vector while making sure to resize mem if needed.
+	 * This is done in one function to avoid redundant copying in case of need to copy
+	 * to new memory and then to move some of the data to make space for new elements.
+	 * Shift elements (if there are) from pos to the right by size, then call pushFunc.
+	 * If pushElements throws the vector is left unchanged, if shifting a non trivially
+	 * relocatable T throws the elements are all kept but possibly reordered.
+	 * @tparam PushFunc: The type of insertion function.
+	 * @param pos: The position in which to push the elements (will be inserted before pos).
+	 * if pos == end then no shifting will take place.
+	 * @param numOfElements: The number of new inserted elements.
+	 * @param pushElements: A function that takes a pointer to numOfElements uninitialized
+	 * slots and constructs the new elements in them.
+	 */
+	template<class PushFunc>
+	VLVECTOR_CONSTEXPR void _pushAt(const T *pos, std::size_t numOfElements, PushFunc pushElements);
+
+	/**
+	 * memcmp based three way comparison for byte like T.
+	 * @param other
+	 * @return Negative, zero or positive like memcmp, shorter is smaller on a common prefix.
+	 */
+	VLVECTOR_CONSTEXPR int _compareBytes(const VLVector &other) const;
+
+#ifdef VLVECTOR_ENABLE_STATS
+	/**
+	 * @return The instrumentation counters of this instantiation.
+	 */
+	static vl_detail::StatCounters& _stats()
+	{
+		static vl_detail::StatCounters counters(vl_detail::typeName<VLVector>(), sizeof(T),
+												StaticCapacity);
+		return counters;
+	}
+
+#ifdef VLVECTOR_STATS_LOCATIONS
+	/**
+	 * @param location
+	 * @return The instrumentation counters of this instantiation constructed at location.
+	 */
+	static vl_detail::StatCounters& _siteStats(const std::source_location &location)
+	{
+		static const std::string name = vl_detail::typeName<VLVector>();
+		static vl_detail::SiteCounters sites;
+		return sites.site(name, sizeof(T), StaticCapacity, location.file_name(), location.line(),
+						  location.column());
+	}
+#endif
+#endif
+public:
+	/**
+	 * @typedef iterator: def T* as iterator since it satisfies all requirements
+	 * for random access iterator.
+	 */
+	typedef T* iterator;
+
+	/**
+	 * @typedef const_iterator: def const T* as const_iterator since
+	 * it satisfies all requirements from const random access iterator.
+	 */
+	typedef const T*  const_iterator;
+
+	/**
+	 * Insert elements in the range [first, last) before pos.
+	 * A forward range is measured first and inserted with at most one reallocation, a single
+	 * pass input range is appended one by one (growing as needed) and rotated into place.
+	 * @tparam InputIterator: Type of first, last, must be at least input iterator.
+	 * @param pos:
+	 * @param first
+	 * @param last:
+	 * @return: Iterator to the first element inserted, or pos if no elements
+	 * were inserted.
+	 */
+	template<class InputIterator>
+	VLVECTOR_CONSTEXPR iterator insert(const_iterator pos, InputIterator first, InputIterator last);
+
+	/**
+	 * @typedef value_type: The type of stored data.
+	 */
+	typedef T value_type;
+
+	/**
+	 * @typedef allocator_type: The allocator used for heap memory and element construction.
+	 */
+	typedef Allocator allocator_type;
+
+	/**
+	 * Default constructor, create an empty VLVector.
+	 */
+#if defined(VLVECTOR_ENABLE_STATS) && defined(VLVECTOR_STATS_LOCATIONS)
+	VLVector(std::source_location location = std::source_location::current()):
+			VLVector(Allocator(), location) {}
+#else
+	VLVECTOR_CONSTEXPR VLVector(): VLVector(Allocator()) {}
+#endif
+
+	/**
+	 * Create an empty VLVector which will use alloc if it needs heap memory.
+	 * @param alloc
+	 */
+	VLVECTOR_CONSTEXPR explicit VLVector(const Allocator& alloc VLVECTOR_LOCATION_PARAM):
+			vl_detail::AllocatorHolder<Allocator>(alloc) { VLVECTOR_LOCATION_INIT }
+
+	/**
+	 * Copy constructor. Create a new VLVector identical to other.
+	 * The copy is counted where other is, see VLVectorStats.hpp.
+	 * @param other
+	 */
+	VLVECTOR_CONSTEXPR VLVector(const VLVector& other): vl_detail::AllocatorHolder<Allocator>(
+			_AllocTraits::select_on_container_copy_construction(other._alloc()))
+	{
+		VLVECTOR_STAT(_objectStats.inherit(other._objectStats));
+		_copyMembers(other);
+	}
+
+	/**
+	 * Move constructor. Takes over other's heap memory if it has one, otherwise moves
+	 * the inline elements. other is left empty.
+	 * @param other
+	 */
+	VLVECTOR_CONSTEXPR VLVector(VLVector&& other) noexcept(
+			std::is_nothrow_move_constructible<T>::value):
+			vl_detail::AllocatorHolder<Allocator>(other._alloc())
+	{
+		VLVECTOR_STAT(_objectStats.inherit(other._objectStats));
+		_moveMembers(other);
+	}
+
+	/**
+	 * Construtor from another range. Has the same effect as creating an empty VLVector,
+	 * then performing insert(begin, first, last).
+	 * @tparam InputIterator: Type of the input iterator to copy values from.
+	 * @param first
+	 * @param last
+	 * @param alloc
+	 */
+	template<class InputIterator>
+	VLVECTOR_CONSTEXPR VLVector(InputIterator first, InputIterator last,
+			 const Allocator& alloc = Allocator() VLVECTOR_LOCATION_PARAM):
+			VLVector(alloc VLVECTOR_LOCATION_ARG) {insert(begin(), first, last); }
+
+	/**
+	 * Destructor. Free memory if needed.
+	 */
+	VLVECTOR_CONSTEXPR ~VLVector();
+
+	/**
+	 * @return number of elements in VLVec.
+	 */
+	VLVECTOR_CONSTEXPR std::size_t size() const { return _store.size(); }
+
+	/**
+	 * @return true if empty, false otherwise.
+	 */
+	VLVECTOR_CONSTEXPR bool empty() const { return size() == 0; }
+
+	/**
+	 * @return numer of elements that can be stored in current mem.
+	 */
+	VLVECTOR_CONSTEXPR std::size_t capacity() const { return _store.capacity(); }
+
+	/**
+	 * @return The largest size the vector can reach, limited by SizeType and the allocator.
+	 */
+	VLVECTOR_CONSTEXPR std::size_t max_size() const
+	{
+		return std::min<std::size_t>(decltype(_store)::maxSize, _AllocTraits::max_size(_alloc()));
+	}
+
+	/**
+	 * @return A copy of the allocator.
+	 */
+	VLVECTOR_CONSTEXPR Allocator get_allocator() const { return _alloc(); }
+
+	/**
+	 * Make sure the vector can hold newCapacity elements without reallocating, using exactly
+	 * one allocation if the current memory is too small. A memory allocated so is kept even
+	 * when erase brings the size back under StaticCapacity, until shrink_to_fit is called.
+	 * A reserve which doesn't allocate leaves everything as it was.
+	 * Throws std::length_error if newCapacity exceeds max_size().
+	 * @param newCapacity
+	 */
+	VLVECTOR_CONSTEXPR void reserve(std::size_t newCapacity);
+
+	/**
+	 * Release unused memory: move back to the inline storage if size() <= StaticCapacity
+	 * (unless DemotionPolicy forbids it), otherwise reallocate the heap memory to exactly
+	 * size() elements.
+	 * Also undoes the effect of reserve on erase.
+	 */
+	VLVECTOR_CONSTEXPR void shrink_to_fit();
+
+	/**
+	 * Change the size to newSize, erasing elements from the end or appending
+	 * value-initialized ones.
+	 * @param newSize
+	 */
+	VLVECTOR_CONSTEXPR void resize(std::size_t newSize);
+
+	/**
+	 * Change the size to newSize, erasing elements from the end or appending copies of value.
+	 * @param newSize
+	 * @param value
+	 */
+	VLVECTOR_CONSTEXPR void resize(std::size_t newSize, const T& value);
+
+	/**
+	 * Change the size to newSize, erasing elements from the end or appending
+	 * default-initialized ones, which for trivial types means their bytes are not written.
+	 * @param newSize
+	 */
+	VLVECTOR_CONSTEXPR void resize_default_init(std::size_t newSize);
+
+	/**
+	 * Append n default-initialized elements (see resize_default_init) to be filled in place,
+	 * e.g. by recv() or a decompressor, without zeroing them first.
+	 * @param n
+	 * @return Pointer to the first appended element (valid until the next reallocation).
+	 */
+	VLVECTOR_CONSTEXPR T* append_uninitialized(std::size_t n);
+
+	/**
+	 * Get value at idx with bound checking.
+	 * @param index
+	 * @return
+	 */
+	VLVECTOR_CONSTEXPR T& at(std::size_t index);
+
+	/**
+ * Get value at idx with bound checking for const.
+ * @param index
+ * @return
+ */
+	VLVECTOR_CONSTEXPR const T& at(std::size_t index) const;
+
+	/**
+	 * Insert value before pos.
+	 * @param pos
+	 * @param value
+	 * @return Iterator pointing to the newly inserted value.
+	 */
+	VLVECTOR_CONSTEXPR iterator insert(const_iterator pos, const T& value)
+	{
+		return emplace(pos, value);
+	}
+
+	/**
+	 * Insert value before pos by moving it.
+	 * @param pos
+	 * @param value
+	 * @return Iterator pointing to the newly inserted value.
+	 */
+	VLVECTOR_CONSTEXPR iterator insert(const_iterator pos, T&& value)
+	{
+		return emplace(pos, std::move(value));
+	}
+
+	/**
+	 * Construct a new element from args before pos.
+	 * @tparam Args: Types of the arguments for T's constructor.
+	 * @param pos
+	 * @param args
+	 * @return Iterator pointing to the newly constructed value.
+	 */
+	template<class... Args>
+	VLVECTOR_CONSTEXPR iterator emplace(const_iterator pos, Args&&... args);
+
+	/**
+	 * push value in the end of vector.
+	 * @param value
+	 */
+	VLVECTOR_CONSTEXPR void push_back(const T& value) { emplace_back(value); }
+
+	/**
+	 * push value in the end of vector by moving it.
+	 * @param value
+	 */
+	VLVECTOR_CONSTEXPR void push_back(T&& value) { emplace_back(std::move(value)); }
+
+	/**
+	 * Construct a new element from args in the end of vector.
+	 * @tparam Args: Types of the arguments for T's constructor.
+	 * @param args
+	 * @return Reference to the new element.
+	 */
+	template<class... Args>
+	VLVECTOR_CONSTEXPR T& emplace_back(Args&&... args);
+
+	/**
+	 * Remove last value from vector.
+	 */
+	VLVECTOR_CONSTEXPR void pop_back() { erase(cend() -  1); }
+
+	/**
+	 * Erase elements in the range [first, last)
+	 * @param first
+	 * @param last
+	 * @return Iterator pointing to the element after the last removed one.
+	 * if first == last,return first.
+	 */
+	VLVECTOR_CONSTEXPR iterator erase(const_iterator first, const_iterator last);
+
+	/**
+	 * erase element at pos.
+	 * @param pos
+	 * @return: Iterator pointing after the removed element.
+	 */
+	VLVECTOR_CONSTEXPR iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+	/**
+	 * Erase the element at pos by moving the last element into its place: O(1), but the
+	 * order of the elements is not kept.
+	 * @param pos
+	 * @return Iterator to the element which took pos's place, or end() if pos was the last.
+	 */
+	VLVECTOR_CONSTEXPR iterator unordered_erase(const_iterator pos);
+
+	/**
+	 * Remove all elements from vec.
+	 */
+	VLVECTOR_CONSTEXPR void clear();
+
+	/**
+	 * @return A pointer to the memory containing the data.
+	 */
+	VLVECTOR_CONSTEXPR T* data() { return _store.data(); }
+
+
+	/**
+	 * @return A const pointer to the memory containing the data (const).
+	 */
+	VLVECTOR_CONSTEXPR const T* data() const { return _store.data(); }
+
+#ifdef __cpp_lib_span
+	/**
+	 * @return The elements, valid until the next reallocation.
+	 */
+	VLVECTOR_CONSTEXPR std::span<T> as_span() { return {data(), size()}; }
+
+	VLVECTOR_CONSTEXPR std::span<const T> as_span() const { return {data(), size()}; }
+
+	/**
+	 * @return The bytes of the elements, e.g. the payload of a VLWireMessage.
+	 */
+	std::span<const std::byte> as_bytes() const { return std::as_bytes(as_span()); }
+
+	std::span<std::byte> as_writable_bytes() { return std::as_writable_bytes(as_span()); }
+#endif
+
+	/**
+	 * Take ownership of a heap memory from get_allocator(), e.g. one a payload was received
+	 * into, replacing the elements. The vector frees it later as its own. A memory not bigger
+	 * than StaticCapacity has its elements moved inline and is freed right away.
+	 * Throws std::length_error, before taking ownership, if size > capacity or capacity
+	 * exceeds max_size().
+	 * @param mem: Holds capacity slots, the first size are alive (for trivially copyable T,
+	 * written bytes are enough).
+	 * @param size
+	 * @param capacity
+	 */
+	VLVECTOR_CONSTEXPR void adopt(T* mem, std::size_t size, std::size_t capacity);
+
+	/**
+	 * Assignment operator. The current memory is reused if it can hold other's elements.
+	 * @param other
+	 * @return : this after assigment.
+	 */
+	VLVECTOR_CONSTEXPR VLVector& operator=(const VLVector& other);
+
+	/**
+	 * Replace the contents with the range [first, last), reusing the current memory if it
+	 * is big enough (elements are copy assigned over the existing ones), otherwise moving to
+	 * a memory of exactly the range's size.
+	 * @tparam InputIterator: Type of first, last, must be at least input iterator.
+	 * @param first
+	 * @param last
+	 */
+	template<class InputIterator, class = typename std::iterator_traits<
+			InputIterator>::iterator_category>
+	VLVECTOR_CONSTEXPR void assign(InputIterator first, InputIterator last);
+
+	/**
+	 * Replace the contents with count copies of value, see assign(first, last).
+	 * @param count
+	 * @param value
+	 */
+	VLVECTOR_CONSTEXPR void assign(std::size_t count, const T &value);
+
+	/**
+	 * Exchange the contents with other. Heap memories are exchanged as is, only inline
+	 * elements are moved. The allocators are swapped if they propagate on swap, if they
+	 * don't and differ all the elements are moved.
+	 * @param other
+	 */
+	VLVECTOR_CONSTEXPR void swap(VLVector &other) noexcept(
+			std::is_nothrow_move_constructible<T>::value && std::is_nothrow_swappable<T>::value
+			&& (_AllocTraits::propagate_on_container_swap::value
+				|| _AllocTraits::is_always_equal::value));
+
+	/**
+	 * Move assignment operator, see move constructor. If the allocator does not propagate
+	 * and differs from other's, the elements are moved one by one instead.
+	 * @param other
+	 * @return : this after assigment.
+	 */
+	VLVECTOR_CONSTEXPR VLVector& operator=(VLVector&& other) noexcept(
+			std::is_nothrow_move_constructible<T>::value
+			&& (_AllocTraits::propagate_on_container_move_assignment::value
+				|| _AllocTraits::is_always_equal::value));
+
+	/**
+	 * Access at idx [non-const], no bound checking.
+	 * @param idx
+	 * @return Value at idx by ref.
+	 */
+	VLVECTOR_CONSTEXPR T& operator[](std::size_t idx) { return data()[idx]; }
+
+	/**
+ * Access at idx [const], no bound checking.
+ * @param idx
+ * @return Value at idx by cosnt ref.
+ */
+	VLVECTOR_CONSTEXPR const T& operator[](std::size_t idx) const { return data()[idx]; }
+
+	/**
+	 * @param other
+	 * @return true if this == other elementwise. A single memcmp for types with unique
+	 * object representations.
+	 */
+	VLVECTOR_CONSTEXPR bool operator==(const VLVector& other) const;
+
+	/**
+	 * @param other
+	 * @return negation of operator==.
+	 */
+	VLVECTOR_CONSTEXPR bool operator!=(const VLVector& other) const { return !operator==(other); }
+
+#if __cpp_lib_three_way_comparison
+	/**
+	 * Lexicographic comparison. A single memcmp for unsigned byte types.
+	 * @param other
+	 * @return The ordering of the first differing elements, or of the sizes.
+	 */
+	VLVECTOR_CONSTEXPR auto operator<=>(const VLVector& other) const
+			requires std::three_way_comparable<T>
+	{
+		if constexpr (vl_detail::IsByteLike<T>::value)
+		{
+			if (!vl_detail::constantEvaluated())
+			{
+				return _compareBytes(other) <=> 0;
+			}
+		}
+		return std::lexicographical_compare_three_way(begin(), end(), other.begin(), other.end());
+	}
+#else
+	/**
+	 * Lexicographic comparison. A single memcmp for unsigned byte types.
+	 * @param other
+	 * @return true if this is before other.
+	 */
+	VLVECTOR_CONSTEXPR bool operator<(const VLVector& other) const
+	{
+		if constexpr (vl_detail::IsByteLike<T>::value)
+		{
+			if (!vl_detail::constantEvaluated())
+			{
+				return _compareBytes(other) < 0;
+			}
+		}
+		return std::lexicographical_compare(begin(), end(), other.begin(), other.end());
+	}
+
+	VLVECTOR_CONSTEXPR bool operator>(const VLVector& other) const { return other < *this; }
+
+	VLVECTOR_CONSTEXPR bool operator<=(const VLVector& other) const { return !(other < *this); }
+
+	VLVECTOR_CONSTEXPR bool operator>=(const VLVector& other) const { return !(*this < other); }
+#endif
+
+	/**
+	 * Find the first element equal to value, vectorized for arithmetic types.
+	 * @param value
+	 * @return Iterator to the element, or end() if there is none.
+	 */
+	VLVECTOR_CONSTEXPR iterator find(const T& value)
+	{
+		return begin() + (static_cast<const VLVector*>(this)->find(value) - cbegin());
+	}
+
+	/**
+	 * Find the first element equal to value, vectorized for arithmetic types (const).
+	 * @param value
+	 * @return Iterator to the element, or end() if there is none.
+	 */
+	VLVECTOR_CONSTEXPR const_iterator find(const T& value) const;
+
+	/**
+	 * @param value
+	 * @return Number of elements equal to value, vectorized for arithmetic types.
+	 */
+	VLVECTOR_CONSTEXPR std::size_t count(const T& value) const;
+
+	/**
+	 * @return iterator pointing to first element.
+	 */
+	VLVECTOR_CONSTEXPR iterator begin() { return data(); }
+
+	/**
+	 * @return iterator pointing after last element.
+	 */
+	VLVECTOR_CONSTEXPR iterator end() { return data() + size(); }
+
+	/**
+	 * @return const iterator pointing to first element for const vec.
+	 */
+	VLVECTOR_CONSTEXPR const_iterator begin() const { return data(); }
+
+	/**
+ * @return const iterator pointing after the last element for const vec.
+ */
+	VLVECTOR_CONSTEXPR const_iterator end() const { return data() + size(); }
+
+	/**
+	 * @return const iterator pointing to first element.
+	 */
+	VLVECTOR_CONSTEXPR const_iterator cbegin() const { return data(); }
+
+	/**
+	 * @return const iterator pointing after last element.
+	 */
+	VLVECTOR_CONSTEXPR const_iterator cend() const  { return data() + size(); }
+
+};
+
+/**
+ * Shorthands for the out of class member definitions below, undefined at the end of the file.
+ */
+#define VLVECTOR_TEMPLATE template<class T, std::size_t StaticCapacity, class GrowthPolicy, \
+										 class SizeType, class Allocator, class DemotionPolicy, \
+										 class Layout, std::size_t Alignment>
+#define VLVECTOR_CLASS VLVector<T, StaticCapacity, GrowthPolicy, SizeType, Allocator, \
+								DemotionPolicy, Layout, Alignment>
+
+VLVECTOR_TEMPLATE
+template<class InputIterator>
+VLVECTOR_CONSTEXPR T *VLVECTOR_CLASS::_uninitializedCopy(InputIterator first, InputIterator last,
+														 T *dest)
+{
+	if constexpr (_bitwiseCopy && std::is_pointer<InputIterator>::value
+				  && std::is_same<typename std::remove_cv<typename std::remove_pointer<
+						  InputIterator>::type>::type, T>::value)
+	{
+		std::size_t count = last - first;
+		if (count > 0 && !vl_detail::constantEvaluated())
+		{
+			_copyBytes(static_cast<void*>(dest), static_cast<const void*>(first),
+					   count * sizeof(T));
+			return dest + count;
+		}
+	}
+	T* current = dest;
+	try
+	{
+		for (; first != last; ++first, ++current)
+		{
+			_construct(current, *first);
+		}
+	}
+	catch (...)
+	{
+		_destroy(dest, current);
+		throw;
+	}
+	return current;
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::_relocate(T *first, T *last, T *dest)
+{
+	if constexpr (_bitwiseRelocate)
+	{
+		if (!vl_detail::constantEvaluated())
+		{
+			std::size_t count = last - first;
+			std::less<const T*> before;
+			if (count == 0)
+			{
+				return;
+			}
+			// Growth and copies move to another memory, a shift in place overlaps.
+			if (!before(first, dest + count) || !before(dest, last))
+			{
+				_copyBytes(static_cast<void*>(dest), static_cast<const void*>(first),
+						   count * sizeof(T));
+			}
+			else
+			{
+				std::memmove(static_cast<void*>(dest), static_cast<const void*>(first),
+							 count * sizeof(T));
+			}
+			return;
+		}
+	}
+	_uninitializedCopy(_RelocateIterator(first), _RelocateIterator(last), dest);
+	_destroy(first, last);
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::_relocateParts(T *first, T *last, T *dest, T *secondFirst,
+													   T *secondLast, T *secondDest)
+{
+	if constexpr (_bitwiseRelocate)
+	{
+		_relocate(first, last, dest);
+		_relocate(secondFirst, secondLast, secondDest);
+	}
+	else
+	{
+		// Construct both parts before destroying any source, so a throwing copy of the second
+		// part can still be rolled back.
+		T* destEnd = _uninitializedCopy(_RelocateIterator(first), _RelocateIterator(last), dest);
+		try
+		{
+			_uninitializedCopy(_RelocateIterator(secondFirst), _RelocateIterator(secondLast),
+							   secondDest);
+		}
+		catch (...)
+		{
+			_destroy(dest, destEnd);
+			throw;
+		}
+		_destroy(first, last);
+		_destroy(secondFirst, secondLast);
+	}
+}
+
+VLVECTOR_TEMPLATE
+template<class... Args>
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::_uninitializedFill(T *dest, std::size_t count,
+														  const Args&... args)
+{
+	T* current = dest;
+	try
+	{
+		for (; count > 0; --count, ++current)
+		{
+			_construct(current, args...);
+		}
+	}
+	catch (...)
+	{
+		_destroy(dest, current);
+		throw;
+	}
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::_uninitializedDefault(T *dest, std::size_t count)
+{
+	if constexpr (vl_detail::UsesDefaultConstruct<Allocator, T>::value)
+	{
+		// Placement new can't be evaluated at compile time, which value initializes instead.
+		if (!vl_detail::constantEvaluated())
+		{
+			T* current = dest;
+			try
+			{
+				for (; count > 0; --count, ++current)
+				{
+					::new (static_cast<void*>(current)) T;
+				}
+			}
+			catch (...)
+			{
+				_destroy(dest, current);
+				throw;
+			}
+			return;
+		}
+	}
+	_uninitializedFill(dest, count);
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR T &VLVECTOR_CLASS::at(std::size_t index)
+{
+	if (index >= size())
+	{
+		throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
+	}
+	return data()[index];
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR const T &VLVECTOR_CLASS::at(std::size_t index) const
+{
+	if (index >= size())
+	{
+		throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
+	}
+	return data()[index];
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR bool VLVECTOR_CLASS::operator==(const VLVector &other) const
+{
+	if (size() != other.size())
+	{
+		return false;
+	}
+	if constexpr (std::has_unique_object_representations<T>::value)
+	{
+		if (!vl_detail::constantEvaluated())
+		{
+			return empty() || std::memcmp(data(), other.data(), size() * sizeof(T)) == 0;
+		}
+	}
+	return std::equal(begin(), end(), other.begin());
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR int VLVECTOR_CLASS::_compareBytes(const VLVector &other) const
+{
+	std::size_t common = std::min(size(), other.size());
+	int result = common == 0? 0: std::memcmp(data(), other.data(), common);
+	if (result != 0)
+	{
+		return result;
+	}
+	return size() < other.size()? -1: size() > other.size()? 1: 0;
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR typename VLVECTOR_CLASS::const_iterator
+VLVECTOR_CLASS::find(const T &value) const
+{
+	if constexpr (std::is_arithmetic<T>::value)
+	{
+		return vl_detail::findArithmetic(cbegin(), cend(), value);
+	}
+	return std::find(cbegin(), cend(), value);
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR std::size_t VLVECTOR_CLASS::count(const T &value) const
+{
+	if constexpr (std::is_arithmetic<T>::value)
+	{
+		return vl_detail::countArithmetic(cbegin(), cend(), value);
+	}
+	return std::count(cbegin(), cend(), value);
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR std::size_t VLVECTOR_CLASS::_cap(std::size_t additionalSize) const
+{
+	return vl_detail::growCapacity<GrowthPolicy>(size(), additionalSize, StaticCapacity, max_size(),
+												 sizeof(T));
+}
+
+VLVECTOR_TEMPLATE
+template<class InputIterator>
+VLVECTOR_CONSTEXPR typename VLVECTOR_CLASS::iterator
+VLVECTOR_CLASS::insert(VLVector::const_iterator pos, InputIterator first,
+									InputIterator last)
+{
+	std::size_t posIdx = pos - begin();
+	if constexpr (std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<
+			InputIterator>::iterator_category>::value)
+	{
+		std::size_t numOfElements = std::distance(first, last);
+		auto pushFunc = [&](T* slot) {_uninitializedCopy(first, last, slot); };
+		// Push the elements by using pushFunc after rest will be shifted right.
+		_pushAt(pos, numOfElements, pushFunc);
+	}
+	else
+	{
+		// The range can be read only once, so append it and move it before pos afterwards.
+		std::size_t oldSize = size();
+		try
+		{
+			for (; first != last; ++first)
+			{
+				emplace_back(*first);
+			}
+		}
+		catch (...)
+		{
+			erase(begin() + oldSize, end());
+			throw;
+		}
+		std::rotate(begin() + posIdx, begin() + oldSize, end());
+	}
+	return begin() + posIdx; // Iterator to the first inserted element.
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR typename VLVECTOR_CLASS::iterator
+VLVECTOR_CLASS::erase(VLVector::const_iterator first, VLVector::const_iterator last)
+{
+	std::size_t toRemoveSize = last - first, firstIdx = first - begin(), lastIdx = last - begin();
+	if (_store.onHeap() && !_store.pinned()
+		&& DemotionPolicy::onErase(size() - toRemoveSize, StaticCapacity))
+	{
+		// Move the kept elements to the inline storage, then drop the heap block entirely.
+		// The heap block is saved first, the compact layout keeps it in the inline slots.
+		T* oldMem = data();
+		T* oldEnd = end();
+		std::size_t oldCapacity = capacity();
+		_startInlinePlaceholders();
+		try
+		{
+			_relocateParts(oldMem, oldMem + firstIdx, _staticData(), oldMem + lastIdx, oldEnd,
+						   _staticData() + firstIdx);
+		}
+		catch (...)
+		{
+			_store.setHeap(oldMem, oldCapacity);
+			throw;
+		}
+		VLVECTOR_STAT(_objectStats.onDemotion(size() - toRemoveSize));
+		_destroy(oldMem + firstIdx, oldMem + lastIdx);
+		_deallocate(oldMem, oldCapacity);
+		_store.setInline();
+	}
+	else if (_bitwiseRelocate && !vl_detail::constantEvaluated())
+	{
+		_destroy(begin() + firstIdx, begin() + lastIdx);
+		_relocate(begin() + lastIdx, end(), begin() + firstIdx);
+	}
+	else if (toRemoveSize > 0) // An empty range would move assign the tail onto itself.
+	{
+		std::move(begin() + lastIdx, end(), begin() + firstIdx);
+		_destroy(end() - toRemoveSize, end());
+	}
+	_store.setSize(size() - toRemoveSize);
+	return begin() + firstIdx;
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR typename VLVECTOR_CLASS::iterator
+VLVECTOR_CLASS::unordered_erase(VLVector::const_iterator pos)
+{
+	std::size_t idx = pos - cbegin();
+	T* last = end() - 1;
+	if (begin() + idx != last)
+	{
+		begin()[idx] = std::move(*last);
+	}
+	pop_back();
+	return begin() + idx;
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::clear()
+{
+	erase(begin(), end());
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR VLVECTOR_CLASS& VLVECTOR_CLASS::operator=(const VLVector &other)
+{
+	if (&other == this)
+	{
+		return *this;
+	}
+	if constexpr (_AllocTraits::propagate_on_container_copy_assignment::value)
+	{
+		if (!_AllocTraits::is_always_equal::value && _alloc() != other._alloc())
+		{
+			// The current memory belongs to the old allocator.
+			_release();
+		}
+		_alloc() = other._alloc();
+	}
+	assign(other.begin(), other.end());
+	return *this;
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR VLVECTOR_CLASS& VLVECTOR_CLASS::operator=(VLVector &&other) noexcept(
+		std::is_nothrow_move_constructible<T>::value
+		&& (_AllocTraits::propagate_on_container_move_assignment::value
+			|| _AllocTraits::is_always_equal::value))
+{
+	if (&other == this)
+	{
+		return *this;
+	}
+	_release();
+	if constexpr (_AllocTraits::propagate_on_container_move_assignment::value)
+	{
+		_alloc() = std::move(other._alloc());
+	}
+	_moveMembers(other);
+	return *this;
+}
+
+VLVECTOR_TEMPLATE
+template<class InputIterator, class>
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::assign(InputIterator first, InputIterator last)
+{
+	if constexpr (std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<
+			InputIterator>::iterator_category>::value)
+	{
+		std::size_t count = std::distance(first, last);
+		if (count > capacity())
+		{
+			_destroy(begin(), end());
+			_store.setSize(0);
+			_reallocate(count);
+		}
+		std::size_t common = std::min(count, size());
+		InputIterator mid = std::next(first, common);
+		std::copy(first, mid, begin());
+		if (count > size())
+		{
+			_uninitializedCopy(mid, last, end());
+		}
+		else
+		{
+			_destroy(begin() + count, end());
+		}
+		_store.setSize(count);
+		VLVECTOR_STAT(_objectStats.onSize(size()));
+	}
+	else
+	{
+		T* dest = begin();
+		for (; dest != end() && first != last; ++dest, ++first)
+		{
+			*dest = *first;
+		}
+		erase(dest, end());
+		insert(end(), first, last);
+	}
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::assign(std::size_t count, const T &value)
+{
+	if (count > capacity())
+	{
+		// value may be one of the elements about to be destroyed.
+		T copy(value);
+		_destroy(begin(), end());
+		_store.setSize(0);
+		_reallocate(count);
+		_uninitializedFill(begin(), count, copy);
+		_store.setSize(count);
+		VLVECTOR_STAT(_objectStats.onSize(size()));
+		return;
+	}
+	std::size_t common = std::min(count, size());
+	std::fill(begin(), begin() + common, value);
+	if (count > size())
+	{
+		_uninitializedFill(end(), count - size(), value);
+	}
+	else
+	{
+		_destroy(begin() + count, end());
+	}
+	_store.setSize(count);
+	VLVECTOR_STAT(_objectStats.onSize(size()));
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::swap(VLVector &other) noexcept(
+		std::is_nothrow_move_constructible<T>::value && std::is_nothrow_swappable<T>::value
+		&& (_AllocTraits::propagate_on_container_swap::value
+			|| _AllocTraits::is_always_equal::value))
+{
+	if (&other == this)
+	{
+		return;
+	}
+	if constexpr (!_AllocTraits::propagate_on_container_swap::value
+				  && !_AllocTraits::is_always_equal::value)
+	{
+		if (_alloc() != other._alloc())
+		{
+			// Neither memory may be freed by the other allocator, so move the elements.
+			VLVector temp(std::move(other));
+			other = std::move(*this);
+			*this = std::move(temp);
+			return;
+		}
+	}
+	if constexpr (_AllocTraits::propagate_on_container_swap::value)
+	{
+		using std::swap;
+		swap(_alloc(), other._alloc());
+	}
+	if (_store.onHeap() && other._store.onHeap())
+	{
+		T* mem = data();
+		std::size_t memCapacity = capacity();
+		bool pinned = _store.pinned();
+		_store.setHeap(other.data(), other.capacity());
+		_store.setPinned(other._store.pinned());
+		other._store.setHeap(mem, memCapacity);
+		other._store.setPinned(pinned);
+	}
+	else if (!_store.onHeap() && !other._store.onHeap())
+	{
+		VLVector &shorter = size() < other.size()? *this: other;
+		VLVector &longer = size() < other.size()? other: *this;
+		std::swap_ranges(shorter.begin(), shorter.end(), longer.begin());
+		longer._relocate(longer.begin() + shorter.size(), longer.end(), shorter.end());
+	}
+	else
+	{
+		// Move the inline elements over the heap side's inline storage, which the compact
+		// layout uses for the heap pointer, so that is saved first.
+		VLVector &heapSide = _store.onHeap()? *this: other;
+		VLVector &inlineSide = _store.onHeap()? other: *this;
+		T* mem = heapSide.data();
+		std::size_t memCapacity = heapSide.capacity();
+		bool pinned = heapSide._store.pinned();
+		heapSide._startInlinePlaceholders();
+		if constexpr (std::is_nothrow_move_constructible<T>::value)
+		{
+			inlineSide._relocate(inlineSide.begin(), inlineSide.end(), heapSide._staticData());
+		}
+		else
+		{
+			try
+			{
+				inlineSide._relocate(inlineSide.begin(), inlineSide.end(),
+									 heapSide._staticData());
+			}
+			catch (...)
+			{
+				heapSide._store.setHeap(mem, memCapacity);
+				throw;
+			}
+		}
+		heapSide._store.setInline();
+		inlineSide._store.setHeap(mem, memCapacity);
+		inlineSide._store.setPinned(pinned);
+		VLVECTOR_STAT(inlineSide._objectStats.onHeap(false));
+	}
+	std::size_t size = this->size();
+	_store.setSize(other.size());
+	other._store.setSize(size);
+	VLVECTOR_STAT(_objectStats.onSize(this->size()));
+	VLVECTOR_STAT(other._objectStats.onSize(other.size()));
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::adopt(T *mem, std::size_t size, std::size_t capacity)
+{
+	if (size > capacity || capacity > max_size())
+	{
+		throw std::length_error(LENGTH_ERR_MSG);
+	}
+	_release();
+	if (capacity > StaticCapacity)
+	{
+		_store.setHeap(mem, capacity);
+		VLVECTOR_STAT(_objectStats.onHeap(true));
+	}
+	else
+	{
+		try
+		{
+			_relocate(mem, mem + size, _staticData());
+		}
+		catch (...)
+		{
+			_destroy(mem, mem + size);
+			_deallocate(mem, capacity);
+			throw;
+		}
+		_deallocate(mem, capacity);
+	}
+	_store.setSize(size);
+	VLVECTOR_STAT(_objectStats.onSize(size));
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::_release()
+{
+	_destroy(begin(), end());
+	if (_store.onHeap())
+	{
+		_deallocate(data(), capacity());
+		_store.setInline();
+		_startInlinePlaceholders();
+	}
+	_store.setSize(0);
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::_copyMembers(const VLVector &other)
+{
+	T* mem = other._store.onHeap()? _allocate(other.capacity()): _staticData();
+	try
+	{
+		_uninitializedCopy(other.begin(), other.end(), mem);
+	}
+	catch (...)
+	{
+		if (mem != _staticData())
+		{
+			_deallocate(mem, other.capacity());
+		}
+		throw;
+	}
+	if (mem != _staticData())
+	{
+		_store.setHeap(mem, other.capacity());
+		VLVECTOR_STAT(_objectStats.onHeap(true));
+	}
+	_store.setSize(other.size());
+	VLVECTOR_STAT(_objectStats.onSize(size()));
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::_moveMembers(VLVector &other)
+{
+	if (other._store.onHeap() && !_AllocTraits::is_always_equal::value
+		&& _alloc() != other._alloc())
+	{
+		// other's memory can't be freed by our allocator, so move into memory of our own.
+		T* mem = _allocate(other.capacity());
+		try
+		{
+			_uninitializedMove(other.begin(), other.end(), mem);
+		}
+		catch (...)
+		{
+			_deallocate(mem, other.capacity());
+			throw;
+		}
+		_store.setHeap(mem, other.capacity());
+		_store.setSize(other.size());
+		VLVECTOR_STAT(_objectStats.onHeap(true));
+		VLVECTOR_STAT(_objectStats.onSize(size()));
+		other._release();
+		return;
+	}
+	if (other._store.onHeap())
+	{
+		_store.setHeap(other.data(), other.capacity());
+		_store.setPinned(other._store.pinned());
+		other._store.setInline();
+		other._startInlinePlaceholders();
+		VLVECTOR_STAT(_objectStats.onHeap(false));
+	}
+	else
+	{
+		other._relocate(other.begin(), other.end(), _staticData());
+	}
+	_store.setSize(other.size());
+	other._store.setSize(0);
+	VLVECTOR_STAT(_objectStats.onSize(size()));
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::_reallocate(std::size_t newCapacity)
+{
+	if (newCapacity > StaticCapacity && _tryReallocate(newCapacity))
+	{
+		return;
+	}
+	// The old memory is saved first, the compact layout keeps a heap block in the inline slots.
+	T* oldMem = data();
+	std::size_t oldCapacity = capacity();
+	bool wasHeap = _store.onHeap();
+	if (newCapacity <= StaticCapacity)
+	{
+		_startInlinePlaceholders();
+	}
+	T* newMem = newCapacity > StaticCapacity? _allocate(newCapacity): _staticData();
+	try
+	{
+		_relocate(oldMem, oldMem + size(), newMem);
+	}
+	catch (...)
+	{
+		if (newMem != _staticData())
+		{
+			_deallocate(newMem, newCapacity);
+		}
+		else
+		{
+			_store.setHeap(oldMem, oldCapacity);
+		}
+		throw;
+	}
+	if (newMem == _staticData())
+	{
+		VLVECTOR_STAT(_objectStats.onDemotion(size()));
+		_store.setInline();
+	}
+	else
+	{
+		VLVECTOR_STAT(_objectStats.onGrowth(!wasHeap, size()));
+		_store.setHeap(newMem, newCapacity);
+	}
+	if (wasHeap)
+	{
+		_deallocate(oldMem, oldCapacity);
+	}
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR bool VLVECTOR_CLASS::_tryReallocate(std::size_t newCapacity)
+{
+	if constexpr (_canReallocate)
+	{
+		if (_store.onHeap() && !vl_detail::constantEvaluated())
+		{
+			_store.setHeap(_alloc().reallocate(data(), capacity(), newCapacity), newCapacity);
+			VLVECTOR_STAT(_objectStats.onGrowth(false, 0));
+			return true;
+		}
+	}
+	return false;
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::reserve(std::size_t newCapacity)
+{
+	if (newCapacity > max_size())
+	{
+		throw std::length_error(LENGTH_ERR_MSG);
+	}
+	if (newCapacity > capacity())
+	{
+		_reallocate(newCapacity);
+		_store.setPinned(true);
+	}
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::shrink_to_fit()
+{
+	_store.setPinned(false);
+	if (!_store.onHeap())
+	{
+		return;
+	}
+	// A heap memory must stay bigger than StaticCapacity to be told apart from the inline one.
+	bool toInline = DemotionPolicy::onShrink && size() <= StaticCapacity;
+	std::size_t newCapacity = toInline? StaticCapacity: std::max(size(), StaticCapacity + 1);
+	if (newCapacity < capacity())
+	{
+		_reallocate(newCapacity);
+	}
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::resize(std::size_t newSize)
+{
+	if (newSize <= size())
+	{
+		erase(cbegin() + newSize, cend());
+		return;
+	}
+	std::size_t toAdd = newSize - size();
+	_pushAt(cend(), toAdd, [&](T* slot) { _uninitializedFill(slot, toAdd); });
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::resize(std::size_t newSize, const T &value)
+{
+	if (newSize <= size())
+	{
+		erase(cbegin() + newSize, cend());
+		return;
+	}
+	std::size_t toAdd = newSize - size();
+	if (_growsByReallocate(toAdd))
+	{
+		// value may live in the memory which is about to be reallocated.
+		T copy(value);
+		_pushAt(cend(), toAdd, [&](T* slot) { _uninitializedFill(slot, toAdd, copy); });
+		return;
+	}
+	_pushAt(cend(), toAdd, [&](T* slot) { _uninitializedFill(slot, toAdd, value); });
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::resize_default_init(std::size_t newSize)
+{
+	if (newSize <= size())
+	{
+		erase(cbegin() + newSize, cend());
+		return;
+	}
+	append_uninitialized(newSize - size());
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR T* VLVECTOR_CLASS::append_uninitialized(std::size_t n)
+{
+	std::size_t oldSize = size();
+	_pushAt(cend(), n, [&](T* slot) { _uninitializedDefault(slot, n); });
+	return begin() + oldSize;
+}
+
+VLVECTOR_TEMPLATE
+template<class PushFunc>
+VLVECTOR_CONSTEXPR void VLVECTOR_CLASS::_pushAt(const T *pos, std::size_t numOfElements, PushFunc
+										  pushElements)
+{
+	std::size_t posIdx = pos - cbegin();
+	// Reallocate if needed and copy around the gap, unless the heap memory can be resized.
+	if (numOfElements > capacity() - size() && !_tryReallocate(_cap(numOfElements)))
+	{
+		// Build the new memory completely before touching the old one, so that if anything
+		// throws this is left unchanged.
+		std::size_t newCapacity = _cap(numOfElements);
+		T* newMem = _allocate(newCapacity);
+		T* gap = newMem + posIdx;
+		try
+		{
+			pushElements(gap);
+		}
+		catch (...)
+		{
+			_deallocate(newMem, newCapacity);
+			throw;
+		}
+		try
+		{
+			_relocateParts(begin(), begin() + posIdx, newMem, begin() + posIdx, end(),
+						   gap + numOfElements);
+		}
+		catch (...)
+		{
+			_destroy(gap, gap + numOfElements);
+			_deallocate(newMem, newCapacity);
+			throw;
+		}
+		VLVECTOR_STAT(_objectStats.onGrowth(!_store.onHeap(), size()));
+		if (_store.onHeap())
+		{
+			_deallocate(data(), capacity());
+		}
+		_store.setHeap(newMem, newCapacity);
+		_store.setSize(size() + numOfElements);
+		VLVECTOR_STAT(_objectStats.onSize(size()));
+		return;
+	}
+	T* first = begin() + posIdx;
+	T* last = end();
+	if (_bitwiseRelocate && !vl_detail::constantEvaluated())
+	{
+		// A single memmove leaves the gap raw, undo it if the new elements can't be built.
+		_relocate(first, last, first + numOfElements);
+		try
+		{
+			pushElements(first);
+		}
+		catch (...)
+		{
+			_relocate(first + numOfElements, last + numOfElements, first);
+			throw;
+		}
+		_store.setSize(size() + numOfElements);
+		VLVECTOR_STAT(_objectStats.onSize(size()));
+		return;
+	}
+	// Build the new elements in the raw slots past the end, where a throw leaves the vector
+	// as it was, then rotate them before pos. All the elements are alive during the rotation,
+	// so a throwing move leaves them valid, if out of order.
+	pushElements(last);
+	_store.setSize(size() + numOfElements);
+	VLVECTOR_STAT(_objectStats.onSize(size()));
+	std::rotate(first, last, end());
+}
+
+VLVECTOR_TEMPLATE
+template<class... Args>
+VLVECTOR_CONSTEXPR typename VLVECTOR_CLASS::iterator
+VLVECTOR_CLASS::emplace(VLVector::const_iterator pos, Args&&... args)
+{
+	std::size_t idx = pos - cbegin();
+	if (pos == cend())
+	{
+		emplace_back(std::forward<Args>(args)...);
+	}
+	else if (size() < capacity() || _growsByReallocate(1))
+	{
+		// args may refer to elements that are about to be shifted (or whose memory is about
+		// to be reallocated), so build the value first.
+		T value(std::forward<Args>(args)...);
+		_pushAt(pos, 1, [&](T* slot) { _construct(slot, std::move(value)); });
+	}
+	else
+	{
+		// The old elements stay untouched until the new one is constructed in the new memory.
+		_pushAt(pos, 1, [&](T* slot) { _construct(slot, std::forward<Args>(args)...); });
+	}
+	return begin() + idx;
+}
+
+VLVECTOR_TEMPLATE
+template<class... Args>
+VLVECTOR_CONSTEXPR T &VLVECTOR_CLASS::emplace_back(Args&&... args)
+{
+	if (size() < capacity()) // Fast path, no shifting and no reallocation.
+	{
+		T* slot = end();
+		_construct(slot, std::forward<Args>(args)...);
+		_store.setSize(size() + 1);
+		VLVECTOR_STAT(_objectStats.onSize(size()));
+		return *slot;
+	}
+	if (_growsByReallocate(1))
+	{
+		// The memory args may refer to is reallocated before the new element is built.
+		T value(std::forward<Args>(args)...);
+		_pushAt(cend(), 1, [&](T* slot) { _construct(slot, std::move(value)); });
+		return data()[size() - 1];
+	}
+	_pushAt(cend(), 1, [&](T* slot) { _construct(slot, std::forward<Args>(args)...); });
+	return data()[size() - 1];
+}
+
+VLVECTOR_TEMPLATE
+VLVECTOR_CONSTEXPR VLVECTOR_CLASS::~VLVector()
+{
+	_release();
+}
+
+/**
+ * Exchange the contents of first and second, see VLVector::swap.
+ * @param first
+ * @param second
+ */
+template<class T, std::size_t StaticCapacity, class GrowthPolicy, class SizeType, class Allocator,
+		 class DemotionPolicy, class Layout, std::size_t Alignment>
+VLVECTOR_CONSTEXPR void swap(VLVECTOR_CLASS &first, VLVECTOR_CLASS &second) noexcept(
+		noexcept(first.swap(second)))
+{
+	first.swap(second);
+}
+
+/**
+ * Erase all the elements of vec for which pred is true. The kept elements are compacted in
+ * one pass, then the tail is erased at once, so the move back to the inline storage is
+ * decided a single time.
+ * @param vec
+ * @param pred
+ * @return The number of erased elements.
+ */
+template<class T, std::size_t StaticCapacity, class GrowthPolicy, class SizeType, class Allocator,
+		 class DemotionPolicy, class Layout, std::size_t Alignment, class Predicate>
+VLVECTOR_CONSTEXPR std::size_t erase_if(VLVECTOR_CLASS &vec, Predicate pred)
+{
+	auto newEnd = std::remove_if(vec.begin(), vec.end(), pred);
+	std::size_t erased = vec.end() - newEnd;
+	vec.erase(newEnd, vec.end());
+	return erased;
+}
+
+/**
+ * Erase all the elements of vec equal to value, see erase_if.
+ * @param vec
+ * @param value
+ * @return The number of erased elements.
+ */
+template<class T, std::size_t StaticCapacity, class GrowthPolicy, class SizeType, class Allocator,
+		 class DemotionPolicy, class Layout, std::size_t Alignment, class U>
+VLVECTOR_CONSTEXPR std::size_t erase(VLVECTOR_CLASS &vec, const U &value)
+{
+	return erase_if(vec, [&value](const T &element) { return element == value; });
+}
+
+/**
+ * @typedef VLAlignedVector: VLVector whose data() is aligned to Alignment and whose heap
+ * capacity is padded to whole Alignment blocks, e.g. VLAlignedVector<float, 64> for AVX-512.
+ */
+template<class T, std::size_t StaticCapacity = DEFAULT_STATIC_CAPACITY,
+		 std::size_t Alignment = CACHE_LINE_SIZE, class GrowthPolicy = VLPaddedGrowth<Alignment>>
+using VLAlignedVector = VLVector<T, StaticCapacity, GrowthPolicy, std::size_t,
+								 VLAlignedAllocator<T, Alignment>, VLDemoteAtCapacity,
+								 VLInlineLayout, Alignment>;
+
+#undef VLVECTOR_STAT
+#undef VLVECTOR_LOCATION_PARAM
+#undef VLVECTOR_LOCATION_ARG
+#undef VLVECTOR_LOCATION_INIT
+#undef VLVECTOR_CLASS
+#undef VLVECTOR_TEMPLATE
+
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+
+namespace pmr
+{
+/**
+ * @typedef VLVector: VLVector whose heap memory comes from a std::pmr::memory_resource,
+ * e.g. pmr::VLVector<int> vec(&monotonicResource).
+ */
+template<class T, std::size_t StaticCapacity = DEFAULT_STATIC_CAPACITY,
+		 class GrowthPolicy = VLRatioGrowth<>, class SizeType = std::size_t,
+		 class DemotionPolicy = VLDemoteAtCapacity, class Layout = VLInlineLayout>
+using VLVector = ::VLVector<T, StaticCapacity, GrowthPolicy, SizeType,
+							std::pmr::polymorphic_allocator<T>, DemotionPolicy, Layout>;
+} // namespace pmr
+#endif
+
+// The packed VLVector<bool> has to be seen wherever VLVector is.
+#include "VLVectorBool.hpp"
+
+#endif // VLVECTOR_HPP
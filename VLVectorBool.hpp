@@ -0,0 +1,1211 @@
+/**
+ * @author Eli Fivelzon, eli.fivelzon@mail.huji.ac.il
+ * The packed VLVector<bool, StaticCapacity>: BITS_PER_WORD flags per word, both inline and on
+ * the heap, with word at a time count, find, comparison, bitwise and/or/xor and range
+ * insert/erase. Included by VLVector.hpp, so every VLVector<bool> is the packed one.
+ */
+#ifndef VLVECTOR_BOOL_HPP
+#define VLVECTOR_BOOL_HPP
+#include "VLVector.hpp"
+#include <bitset>
+#include <climits>
+#include <cstdint>
+#if __has_include(<bit>)
+#include <bit>
+#endif
+
+/**
+ * Flags packed in one word of VLVector<bool>.
+ */
+#define BITS_PER_WORD 64
+
+/**
+ * Error message for exception in case of a bitwise operation between vectors of different sizes.
+ */
+#define SIZE_MISMATCH_ERR_MSG "Sizes of the operands differ."
+
+namespace vl_detail
+{
+/**
+ * @typedef BitWord: The word VLVector<bool> packs its flags in, flag i is bit i % BITS_PER_WORD
+ * of word i / BITS_PER_WORD (least significant first, like Arrow validity bitmaps).
+ */
+typedef std::uint64_t BitWord;
+
+static_assert(sizeof(BitWord) * CHAR_BIT == BITS_PER_WORD, "BitWord must hold BITS_PER_WORD bits.");
+
+/**
+ * @param count: At most BITS_PER_WORD.
+ * @return A word whose count low bits are set.
+ */
+constexpr BitWord lowBits(std::size_t count)
+{
+	return count == 0? 0: ~BitWord(0) >> (BITS_PER_WORD - count);
+}
+
+/**
+ * @param word
+ * @return Number of set bits in word.
+ */
+constexpr std::size_t popCount(BitWord word)
+{
+#if __cpp_lib_bitops
+	return std::popcount(word);
+#elif defined(__GNUC__)
+	return __builtin_popcountll(word);
+#else
+	return std::bitset<BITS_PER_WORD>(word).count();
+#endif
+}
+
+/**
+ * @param word: Must not be zero.
+ * @return Index of the lowest set bit of word.
+ */
+constexpr std::size_t lowestBit(BitWord word)
+{
+#if __cpp_lib_bitops
+	return std::countr_zero(word);
+#elif defined(__GNUC__)
+	return __builtin_ctzll(word);
+#else
+	std::size_t index = 0;
+	for (; !(word & 1); word >>= 1)
+	{
+		++index;
+	}
+	return index;
+#endif
+}
+
+/**
+ * Shift the bits of words[from, count), taken as one number, up by shift bits: bits shifted
+ * past words[count - 1] are lost, zeros are shifted in at words[from].
+ * @param words
+ * @param count
+ * @param from
+ * @param shift
+ */
+VLVECTOR_CONSTEXPR inline void shiftBitsUp(BitWord* words, std::size_t count, std::size_t from,
+										   std::size_t shift)
+{
+	std::size_t wordShift = shift / BITS_PER_WORD, bitShift = shift % BITS_PER_WORD;
+	for (std::size_t i = count; i > from;)
+	{
+		--i;
+		BitWord high = i >= from + wordShift? words[i - wordShift]: 0;
+		BitWord low = i >= from + wordShift + 1? words[i - wordShift - 1]: 0;
+		words[i] = bitShift == 0? high: high << bitShift | low >> (BITS_PER_WORD - bitShift);
+	}
+}
+
+/**
+ * Shift the bits of words[from, count), taken as one number, down by shift bits: bits shifted
+ * below words[from] are lost, zeros are shifted in at words[count - 1].
+ * @param words
+ * @param count
+ * @param from
+ * @param shift
+ */
+VLVECTOR_CONSTEXPR inline void shiftBitsDown(BitWord* words, std::size_t count,
+											 std::size_t from, std::size_t shift)
+{
+	std::size_t wordShift = shift / BITS_PER_WORD, bitShift = shift % BITS_PER_WORD;
+	for (std::size_t i = from; i < count; ++i)
+	{
+		BitWord low = i + wordShift < count? words[i + wordShift]: 0;
+		BitWord high = i + wordShift + 1 < count? words[i + wordShift + 1]: 0;
+		words[i] = bitShift == 0? low: low >> bitShift | high << (BITS_PER_WORD - bitShift);
+	}
+}
+
+/**
+ * Set or clear the bits [first, last) of words, a word at a time.
+ * @param words
+ * @param first
+ * @param last
+ * @param value
+ */
+VLVECTOR_CONSTEXPR inline void fillBits(BitWord* words, std::size_t first, std::size_t last,
+										bool value)
+{
+	if (first == last)
+	{
+		return;
+	}
+	std::size_t firstWord = first / BITS_PER_WORD, lastWord = (last - 1) / BITS_PER_WORD;
+	BitWord firstMask = ~lowBits(first % BITS_PER_WORD);
+	BitWord lastMask = lowBits((last - 1) % BITS_PER_WORD + 1);
+	auto apply = [value](BitWord &word, BitWord mask) { word = value? word | mask: word & ~mask; };
+	if (firstWord == lastWord)
+	{
+		apply(words[firstWord], firstMask & lastMask);
+		return;
+	}
+	apply(words[firstWord], firstMask);
+	for (std::size_t i = firstWord + 1; i < lastWord; ++i)
+	{
+		words[i] = value? ~BitWord(0): 0;
+	}
+	apply(words[lastWord], lastMask);
+}
+
+/**
+ * Copy count bits from bit srcBit of src to bit destBit of dest, up to a word at a time.
+ * The ranges must not overlap.
+ * @param src
+ * @param srcBit
+ * @param dest
+ * @param destBit
+ * @param count
+ */
+VLVECTOR_CONSTEXPR inline void copyBits(const BitWord* src, std::size_t srcBit, BitWord* dest,
+										std::size_t destBit, std::size_t count)
+{
+	while (count > 0)
+	{
+		std::size_t chunk = std::min<std::size_t>(count, BITS_PER_WORD);
+		std::size_t srcWord = srcBit / BITS_PER_WORD, srcShift = srcBit % BITS_PER_WORD;
+		BitWord bits = src[srcWord] >> srcShift;
+		if (srcShift != 0 && srcShift + chunk > BITS_PER_WORD)
+		{
+			bits |= src[srcWord + 1] << (BITS_PER_WORD - srcShift);
+		}
+		BitWord mask = lowBits(chunk);
+		bits &= mask;
+		std::size_t destWord = destBit / BITS_PER_WORD, destShift = destBit % BITS_PER_WORD;
+		dest[destWord] = (dest[destWord] & ~(mask << destShift)) | bits << destShift;
+		if (destShift != 0 && destShift + chunk > BITS_PER_WORD)
+		{
+			std::size_t rest = BITS_PER_WORD - destShift;
+			dest[destWord + 1] = (dest[destWord + 1] & ~(mask >> rest)) | bits >> rest;
+		}
+		srcBit += chunk;
+		destBit += chunk;
+		count -= chunk;
+	}
+}
+
+/**
+ * @class BitReference: The reference to one flag of a VLVector<bool>.
+ */
+class BitReference
+{
+private:
+	BitWord* _word;
+	BitWord _mask;
+public:
+	VLVECTOR_CONSTEXPR BitReference(BitWord* word, BitWord mask): _word(word), _mask(mask) {}
+
+	VLVECTOR_CONSTEXPR operator bool() const { return (*_word & _mask) != 0; }
+
+	VLVECTOR_CONSTEXPR BitReference& operator=(bool value)
+	{
+		*_word = value? *_word | _mask: *_word & ~_mask;
+		return *this;
+	}
+
+	VLVECTOR_CONSTEXPR BitReference& operator=(const BitReference &other)
+	{
+		return *this = static_cast<bool>(other);
+	}
+
+	VLVECTOR_CONSTEXPR bool operator~() const { return !static_cast<bool>(*this); }
+
+	/**
+	 * Negate the flag.
+	 */
+	VLVECTOR_CONSTEXPR void flip() { *_word ^= _mask; }
+
+	/**
+	 * Exchange the flags first and second refer to, for std::swap and the std algorithms.
+	 * @param first
+	 * @param second
+	 */
+	friend VLVECTOR_CONSTEXPR void swap(BitReference first, BitReference second)
+	{
+		bool value = first;
+		first = static_cast<bool>(second);
+		second = value;
+	}
+};
+
+/**
+ * @class BitIterator: Random access iterator over the flags of a VLVector<bool>.
+ * @tparam IsConst: Whether it is the const_iterator, whose reference is a plain bool.
+ */
+template<bool IsConst>
+class BitIterator
+{
+private:
+	template<bool>
+	friend class BitIterator;
+
+	typedef typename std::conditional<IsConst, const BitWord, BitWord>::type _Word;
+
+	_Word* _words;
+	std::size_t _bit;
+public:
+	typedef std::random_access_iterator_tag iterator_category;
+	typedef bool value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef void pointer;
+	typedef typename std::conditional<IsConst, bool, BitReference>::type reference;
+
+	VLVECTOR_CONSTEXPR BitIterator(): _words(nullptr), _bit(0) {}
+
+	VLVECTOR_CONSTEXPR BitIterator(_Word* words, std::size_t bit): _words(words), _bit(bit) {}
+
+	/**
+	 * An iterator converts to a const_iterator.
+	 * @param other
+	 */
+	template<bool OtherConst, class = typename std::enable_if<IsConst && !OtherConst>::type>
+	VLVECTOR_CONSTEXPR BitIterator(const BitIterator<OtherConst> &other):
+			_words(other._words), _bit(other._bit) {}
+
+	/**
+	 * @return The words the iterated vector packs its flags in.
+	 */
+	VLVECTOR_CONSTEXPR _Word* words() const { return _words; }
+
+	/**
+	 * @return Index of the flag this points to.
+	 */
+	VLVECTOR_CONSTEXPR std::size_t bit() const { return _bit; }
+
+	VLVECTOR_CONSTEXPR reference operator*() const
+	{
+		if constexpr (IsConst)
+		{
+			return (_words[_bit / BITS_PER_WORD] >> (_bit % BITS_PER_WORD) & 1) != 0;
+		}
+		else
+		{
+			return BitReference(_words + _bit / BITS_PER_WORD,
+								BitWord(1) << (_bit % BITS_PER_WORD));
+		}
+	}
+
+	VLVECTOR_CONSTEXPR reference operator[](difference_type n) const { return *(*this + n); }
+
+	VLVECTOR_CONSTEXPR BitIterator& operator++()
+	{
+		++_bit;
+		return *this;
+	}
+
+	VLVECTOR_CONSTEXPR BitIterator operator++(int)
+	{
+		BitIterator old = *this;
+		++_bit;
+		return old;
+	}
+
+	VLVECTOR_CONSTEXPR BitIterator& operator--()
+	{
+		--_bit;
+		return *this;
+	}
+
+	VLVECTOR_CONSTEXPR BitIterator operator--(int)
+	{
+		BitIterator old = *this;
+		--_bit;
+		return old;
+	}
+
+	VLVECTOR_CONSTEXPR BitIterator& operator+=(difference_type n)
+	{
+		_bit += n;
+		return *this;
+	}
+
+	VLVECTOR_CONSTEXPR BitIterator& operator-=(difference_type n)
+	{
+		_bit -= n;
+		return *this;
+	}
+
+	VLVECTOR_CONSTEXPR BitIterator operator+(difference_type n) const
+	{
+		return BitIterator(_words, _bit + n);
+	}
+
+	friend VLVECTOR_CONSTEXPR BitIterator operator+(difference_type n, const BitIterator &it)
+	{
+		return it + n;
+	}
+
+	VLVECTOR_CONSTEXPR BitIterator operator-(difference_type n) const
+	{
+		return BitIterator(_words, _bit - n);
+	}
+
+	VLVECTOR_CONSTEXPR difference_type operator-(const BitIterator &other) const
+	{
+		return static_cast<difference_type>(_bit) - static_cast<difference_type>(other._bit);
+	}
+
+	VLVECTOR_CONSTEXPR bool operator==(const BitIterator &other) const
+	{
+		return _bit == other._bit;
+	}
+
+	VLVECTOR_CONSTEXPR bool operator!=(const BitIterator &other) const
+	{
+		return _bit != other._bit;
+	}
+
+	VLVECTOR_CONSTEXPR bool operator<(const BitIterator &other) const { return _bit < other._bit; }
+
+	VLVECTOR_CONSTEXPR bool operator>(const BitIterator &other) const { return _bit > other._bit; }
+
+	VLVECTOR_CONSTEXPR bool operator<=(const BitIterator &other) const
+	{
+		return _bit <= other._bit;
+	}
+
+	VLVECTOR_CONSTEXPR bool operator>=(const BitIterator &other) const
+	{
+		return _bit >= other._bit;
+	}
+};
+} // namespace vl_detail
+
+/**
+ * @class VLVector<bool>: VLVector of flags packed BITS_PER_WORD per word, e.g. a
+ * VLVector<bool, 256> keeps 256 flags in its four inline words. The words are held by a
+ * VLVector of vl_detail::BitWord with the same policies, allocator (rebound) and Layout, so
+ * they move between the inline storage and the heap exactly like its elements.
+ * Like std::vector<bool>, references and iterators are proxies. The bits past size() in the
+ * last word are always zero, so count, comparison and the bitwise operations work a word at a
+ * time. Flags may be accessed in bulk through words().
+ * @tparam StaticCapacity: The number of flags in the inline storage, rounded up to whole words.
+ */
+template<std::size_t StaticCapacity, class GrowthPolicy, class SizeType, class Allocator,
+		 class DemotionPolicy, class Layout, std::size_t Alignment>
+class VLVector<bool, StaticCapacity, GrowthPolicy, SizeType, Allocator, DemotionPolicy, Layout,
+			   Alignment>
+{
+private:
+	static_assert(std::is_same<typename Allocator::value_type, bool>::value,
+				  "Allocator::value_type must be bool.");
+
+	typedef vl_detail::BitWord _Word;
+
+	typedef VLVector<_Word, (StaticCapacity + BITS_PER_WORD - 1) / BITS_PER_WORD, GrowthPolicy,
+					 SizeType, typename std::allocator_traits<Allocator>::template rebind_alloc<
+							 _Word>, DemotionPolicy, Layout,
+					 std::max(Alignment, alignof(_Word))> _Words;
+
+	/**
+	 * The packed flags, exactly as many words as size() needs.
+	 */
+	_Words _words;
+
+	/**
+	 * The number of flags.
+	 */
+	SizeType _size;
+
+	/**
+	 * @param size
+	 * @return The number of words holding size flags.
+	 */
+	static constexpr std::size_t _wordCount(std::size_t size)
+	{
+		return size / BITS_PER_WORD + (size % BITS_PER_WORD != 0);
+	}
+
+	/**
+	 * Insert count zero flags before index pos, shifting the words after it.
+	 * Throws std::length_error if the new size would exceed max_size().
+	 * @param pos
+	 * @param count
+	 */
+	VLVECTOR_CONSTEXPR void _openGap(std::size_t pos, std::size_t count);
+
+	/**
+	 * Keep only the first newSize flags.
+	 * @param newSize: At most size().
+	 */
+	VLVECTOR_CONSTEXPR void _truncate(std::size_t newSize);
+
+	/**
+	 * @param from
+	 * @param value
+	 * @return Index of the first flag equal to value at or after from, or size() if there is
+	 * none.
+	 */
+	VLVECTOR_CONSTEXPR std::size_t _find(std::size_t from, bool value) const;
+
+	/**
+	 * Word at a time lexicographic comparison.
+	 * @param other
+	 * @return Negative, zero or positive, shorter is smaller on a common prefix.
+	 */
+	VLVECTOR_CONSTEXPR int _compare(const VLVector &other) const;
+
+	/**
+	 * Apply op to each word of this and the matching word of other.
+	 * Throws std::invalid_argument if the sizes differ.
+	 * @param other
+	 * @param op
+	 */
+	template<class WordOp>
+	VLVECTOR_CONSTEXPR VLVector& _combine(const VLVector &other, WordOp op);
+public:
+	typedef bool value_type;
+
+	typedef Allocator allocator_type;
+
+	/**
+	 * @typedef reference: Proxy to one flag, converts to and is assignable from bool.
+	 */
+	typedef vl_detail::BitReference reference;
+
+	typedef bool const_reference;
+
+	typedef vl_detail::BitIterator<false> iterator;
+
+	typedef vl_detail::BitIterator<true> const_iterator;
+
+	/**
+	 * Default constructor, create an empty VLVector.
+	 */
+	VLVECTOR_CONSTEXPR VLVector(): VLVector(Allocator()) {}
+
+	/**
+	 * Create an empty VLVector which will use alloc if it needs heap memory.
+	 * @param alloc
+	 */
+	VLVECTOR_CONSTEXPR explicit VLVector(const Allocator& alloc):
+			_words(typename _Words::allocator_type(alloc)), _size(0) {}
+
+	/**
+	 * Construtor from another range, see insert(pos, first, last).
+	 * @tparam InputIterator
+	 * @param first
+	 * @param last
+	 * @param alloc
+	 */
+	template<class InputIterator>
+	VLVECTOR_CONSTEXPR VLVector(InputIterator first, InputIterator last,
+								const Allocator& alloc = Allocator()):
+			VLVector(alloc) { insert(end(), first, last); }
+
+	VLVECTOR_CONSTEXPR VLVector(const VLVector &other) = default;
+
+	/**
+	 * Move constructor, takes over other's words, other is left empty.
+	 * @param other
+	 */
+	VLVECTOR_CONSTEXPR VLVector(VLVector &&other) noexcept:
+			_words(std::move(other._words)), _size(other._size) { other._size = 0; }
+
+	VLVECTOR_CONSTEXPR VLVector& operator=(const VLVector &other) = default;
+
+	/**
+	 * Move assignment operator, see the move constructor.
+	 * @param other
+	 * @return this after assignment.
+	 */
+	VLVECTOR_CONSTEXPR VLVector& operator=(VLVector &&other) noexcept(
+			std::is_nothrow_move_assignable<_Words>::value);
+
+	/**
+	 * @return number of flags.
+	 */
+	VLVECTOR_CONSTEXPR std::size_t size() const { return _size; }
+
+	/**
+	 * @return true if empty, false otherwise.
+	 */
+	VLVECTOR_CONSTEXPR bool empty() const { return _size == 0; }
+
+	/**
+	 * @return number of flags that can be stored in the current words.
+	 */
+	VLVECTOR_CONSTEXPR std::size_t capacity() const { return _words.capacity() * BITS_PER_WORD; }
+
+	/**
+	 * @return The largest size the vector can reach, limited by SizeType and the allocator.
+	 */
+	VLVECTOR_CONSTEXPR std::size_t max_size() const
+	{
+		std::size_t words = _words.max_size(), limit = SizeType(-1);
+		return words >= limit / BITS_PER_WORD? limit: words * BITS_PER_WORD;
+	}
+
+	/**
+	 * @return A copy of the allocator.
+	 */
+	VLVECTOR_CONSTEXPR Allocator get_allocator() const { return Allocator(_words.get_allocator()); }
+
+	/**
+	 * Make sure the vector can hold newCapacity flags without reallocating, see
+	 * VLVector::reserve. Throws std::length_error if newCapacity exceeds max_size().
+	 * @param newCapacity
+	 */
+	VLVECTOR_CONSTEXPR void reserve(std::size_t newCapacity);
+
+	/**
+	 * Release unused words, see VLVector::shrink_to_fit.
+	 */
+	VLVECTOR_CONSTEXPR void shrink_to_fit() { _words.shrink_to_fit(); }
+
+	/**
+	 * Change the size to newSize, erasing flags from the end or appending copies of value.
+	 * @param newSize
+	 * @param value
+	 */
+	VLVECTOR_CONSTEXPR void resize(std::size_t newSize, bool value = false);
+
+	/**
+	 * Get the flag at index with bound checking.
+	 * @param index
+	 * @return
+	 */
+	VLVECTOR_CONSTEXPR reference at(std::size_t index);
+
+	/**
+	 * Get the flag at index with bound checking (const).
+	 * @param index
+	 * @return
+	 */
+	VLVECTOR_CONSTEXPR bool at(std::size_t index) const;
+
+	/**
+	 * Access at index, no bound checking.
+	 * @param index
+	 * @return
+	 */
+	VLVECTOR_CONSTEXPR reference operator[](std::size_t index) { return begin()[index]; }
+
+	/**
+	 * Access at index (const), no bound checking.
+	 * @param index
+	 * @return
+	 */
+	VLVECTOR_CONSTEXPR bool operator[](std::size_t index) const { return cbegin()[index]; }
+
+	/**
+	 * Insert value before pos.
+	 * @param pos
+	 * @param value
+	 * @return Iterator pointing to the inserted flag.
+	 */
+	VLVECTOR_CONSTEXPR iterator insert(const_iterator pos, bool value)
+	{
+		return insert(pos, 1, value);
+	}
+
+	/**
+	 * Insert count copies of value before pos, shifting the flags after it a word at a time.
+	 * @param pos
+	 * @param count
+	 * @param value
+	 * @return Iterator pointing to the first inserted flag, or pos if count is zero.
+	 */
+	VLVECTOR_CONSTEXPR iterator insert(const_iterator pos, std::size_t count, bool value);
+
+	/**
+	 * Insert the flags in the range [first, last) before pos. A forward range is measured
+	 * first and inserted with one shift, a range of another VLVector<bool> is copied a word
+	 * at a time.
+	 * @tparam InputIterator: Type of first, last, must be at least input iterator.
+	 * @param pos
+	 * @param first
+	 * @param last
+	 * @return Iterator to the first flag inserted, or pos if no flags were inserted.
+	 */
+	template<class InputIterator, class = typename std::iterator_traits<
+			InputIterator>::iterator_category>
+	VLVECTOR_CONSTEXPR iterator insert(const_iterator pos, InputIterator first,
+									   InputIterator last);
+
+	/**
+	 * Insert bool(args...) before pos.
+	 * @param pos
+	 * @param args
+	 * @return Iterator pointing to the inserted flag.
+	 */
+	template<class... Args>
+	VLVECTOR_CONSTEXPR iterator emplace(const_iterator pos, Args&&... args)
+	{
+		return insert(pos, 1, bool(std::forward<Args>(args)...));
+	}
+
+	/**
+	 * push value in the end of vector.
+	 * @param value
+	 */
+	VLVECTOR_CONSTEXPR void push_back(bool value);
+
+	/**
+	 * Append bool(args...).
+	 * @param args
+	 * @return Reference to the new flag.
+	 */
+	template<class... Args>
+	VLVECTOR_CONSTEXPR reference emplace_back(Args&&... args)
+	{
+		push_back(bool(std::forward<Args>(args)...));
+		return (*this)[size() - 1];
+	}
+
+	/**
+	 * Remove the last flag.
+	 */
+	VLVECTOR_CONSTEXPR void pop_back() { _truncate(size() - 1); }
+
+	/**
+	 * Erase the flags in the range [first, last), shifting the flags after it a word at a time.
+	 * @param first
+	 * @param last
+	 * @return Iterator pointing to the flag after the last removed one.
+	 */
+	VLVECTOR_CONSTEXPR iterator erase(const_iterator first, const_iterator last);
+
+	/**
+	 * Erase the flag at pos.
+	 * @param pos
+	 * @return Iterator pointing after the removed flag.
+	 */
+	VLVECTOR_CONSTEXPR iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+	/**
+	 * Erase the flag at pos by moving the last flag into its place, see VLVector::unordered_erase.
+	 * @param pos
+	 * @return Iterator to the flag which took pos's place, or end() if pos was the last.
+	 */
+	VLVECTOR_CONSTEXPR iterator unordered_erase(const_iterator pos);
+
+	/**
+	 * Remove all flags.
+	 */
+	VLVECTOR_CONSTEXPR void clear() { _truncate(0); }
+
+	/**
+	 * Replace the contents with count copies of value, reusing the current words.
+	 * @param count
+	 * @param value
+	 */
+	VLVECTOR_CONSTEXPR void assign(std::size_t count, bool value);
+
+	/**
+	 * Replace the contents with the range [first, last), reusing the current words.
+	 * @tparam InputIterator: Type of first, last, must be at least input iterator.
+	 * @param first
+	 * @param last
+	 */
+	template<class InputIterator, class = typename std::iterator_traits<
+			InputIterator>::iterator_category>
+	VLVECTOR_CONSTEXPR void assign(InputIterator first, InputIterator last)
+	{
+		clear();
+		insert(end(), first, last);
+	}
+
+	/**
+	 * Exchange the contents with other, see VLVector::swap.
+	 * @param other
+	 */
+	VLVECTOR_CONSTEXPR void swap(VLVector &other) noexcept(noexcept(_words.swap(other._words)))
+	{
+		_words.swap(other._words);
+		std::swap(_size, other._size);
+	}
+
+	/**
+	 * @return The words holding the flags, see vl_detail::BitWord. The bits past size() in the
+	 * last word must be left zero.
+	 */
+	VLVECTOR_CONSTEXPR vl_detail::BitWord* words() { return _words.data(); }
+
+	/**
+	 * @return The words holding the flags (const), see vl_detail::BitWord.
+	 */
+	VLVECTOR_CONSTEXPR const vl_detail::BitWord* words() const { return _words.data(); }
+
+	/**
+	 * @return The number of words holding the flags.
+	 */
+	VLVECTOR_CONSTEXPR std::size_t word_count() const { return _words.size(); }
+
+	/**
+	 * @param value
+	 * @return Number of flags equal to value, a population count per word.
+	 */
+	VLVECTOR_CONSTEXPR std::size_t count(bool value = true) const;
+
+	/**
+	 * @return Index of the first set flag, or size() if there is none.
+	 */
+	VLVECTOR_CONSTEXPR std::size_t find_first() const { return _find(0, true); }
+
+	/**
+	 * @param index
+	 * @return Index of the first set flag after index, or size() if there is none.
+	 */
+	VLVECTOR_CONSTEXPR std::size_t find_next(std::size_t index) const
+	{
+		return index + 1 >= size()? size(): _find(index + 1, true);
+	}
+
+	/**
+	 * Find the first flag equal to value, a word at a time.
+	 * @param value
+	 * @return Iterator to the flag, or end() if there is none.
+	 */
+	VLVECTOR_CONSTEXPR iterator find(bool value) { return begin() + _find(0, value); }
+
+	/**
+	 * Find the first flag equal to value, a word at a time (const).
+	 * @param value
+	 * @return Iterator to the flag, or end() if there is none.
+	 */
+	VLVECTOR_CONSTEXPR const_iterator find(bool value) const { return cbegin() + _find(0, value); }
+
+	/**
+	 * Negate every flag.
+	 */
+	VLVECTOR_CONSTEXPR void flip();
+
+	/**
+	 * Flagwise and with other. Throws std::invalid_argument if the sizes differ.
+	 * @param other
+	 * @return this.
+	 */
+	VLVECTOR_CONSTEXPR VLVector& operator&=(const VLVector &other)
+	{
+		return _combine(other, [](_Word &word, _Word otherWord) { word &= otherWord; });
+	}
+
+	/**
+	 * Flagwise or with other. Throws std::invalid_argument if the sizes differ.
+	 * @param other
+	 * @return this.
+	 */
+	VLVECTOR_CONSTEXPR VLVector& operator|=(const VLVector &other)
+	{
+		return _combine(other, [](_Word &word, _Word otherWord) { word |= otherWord; });
+	}
+
+	/**
+	 * Flagwise exclusive or with other. Throws std::invalid_argument if the sizes differ.
+	 * @param other
+	 * @return this.
+	 */
+	VLVECTOR_CONSTEXPR VLVector& operator^=(const VLVector &other)
+	{
+		return _combine(other, [](_Word &word, _Word otherWord) { word ^= otherWord; });
+	}
+
+	/**
+	 * @param other
+	 * @return true if this == other flagwise, a word at a time.
+	 */
+	VLVECTOR_CONSTEXPR bool operator==(const VLVector &other) const
+	{
+		return _size == other._size && _words == other._words;
+	}
+
+	/**
+	 * @param other
+	 * @return negation of operator==.
+	 */
+	VLVECTOR_CONSTEXPR bool operator!=(const VLVector &other) const { return !operator==(other); }
+
+#if __cpp_lib_three_way_comparison
+	/**
+	 * Lexicographic comparison (false before true), a word at a time.
+	 * @param other
+	 * @return The ordering of the first differing flags, or of the sizes.
+	 */
+	VLVECTOR_CONSTEXPR std::strong_ordering operator<=>(const VLVector &other) const
+	{
+		return _compare(other) <=> 0;
+	}
+#else
+	/**
+	 * Lexicographic comparison (false before true), a word at a time.
+	 * @param other
+	 * @return true if this is before other.
+	 */
+	bool operator<(const VLVector &other) const { return _compare(other) < 0; }
+
+	bool operator>(const VLVector &other) const { return _compare(other) > 0; }
+
+	bool operator<=(const VLVector &other) const { return _compare(other) <= 0; }
+
+	bool operator>=(const VLVector &other) const { return _compare(other) >= 0; }
+#endif
+
+	/**
+	 * @return iterator pointing to first flag.
+	 */
+	VLVECTOR_CONSTEXPR iterator begin() { return iterator(_words.data(), 0); }
+
+	/**
+	 * @return iterator pointing after last flag.
+	 */
+	VLVECTOR_CONSTEXPR iterator end() { return iterator(_words.data(), size()); }
+
+	/**
+	 * @return const iterator pointing to first flag for const vec.
+	 */
+	VLVECTOR_CONSTEXPR const_iterator begin() const { return cbegin(); }
+
+	/**
+	 * @return const iterator pointing after the last flag for const vec.
+	 */
+	VLVECTOR_CONSTEXPR const_iterator end() const { return cend(); }
+
+	/**
+	 * @return const iterator pointing to first flag.
+	 */
+	VLVECTOR_CONSTEXPR const_iterator cbegin() const { return const_iterator(_words.data(), 0); }
+
+	/**
+	 * @return const iterator pointing after last flag.
+	 */
+	VLVECTOR_CONSTEXPR const_iterator cend() const
+	{
+		return const_iterator(_words.data(), size());
+	}
+};
+
+/**
+ * Shorthands for the out of class member definitions below, undefined at the end of the file.
+ */
+#define VLVECTOR_BOOL_TEMPLATE template<std::size_t StaticCapacity, class GrowthPolicy, \
+										  class SizeType, class Allocator, class DemotionPolicy, \
+										  class Layout, std::size_t Alignment>
+#define VLVECTOR_BOOL_CLASS VLVector<bool, StaticCapacity, GrowthPolicy, SizeType, Allocator, \
+									 DemotionPolicy, Layout, Alignment>
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_BOOL_CLASS::_openGap(std::size_t pos, std::size_t count)
+{
+	if (count > max_size() - size())
+	{
+		throw std::length_error(LENGTH_ERR_MSG);
+	}
+	if (count == 0)
+	{
+		return;
+	}
+	std::size_t newSize = size() + count;
+	_words.resize(_wordCount(newSize));
+	// The flags before pos in its word are kept aside and the word shifted with the rest.
+	_Word* words = _words.data();
+	std::size_t first = pos / BITS_PER_WORD;
+	_Word kept = words[first] & vl_detail::lowBits(pos % BITS_PER_WORD);
+	words[first] ^= kept;
+	vl_detail::shiftBitsUp(words, _words.size(), first, count);
+	words[first] |= kept;
+	_size = static_cast<SizeType>(newSize);
+}
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_BOOL_CLASS::_truncate(std::size_t newSize)
+{
+	_words.resize(_wordCount(newSize));
+	if (newSize % BITS_PER_WORD != 0)
+	{
+		_words.data()[newSize / BITS_PER_WORD] &= vl_detail::lowBits(newSize % BITS_PER_WORD);
+	}
+	_size = static_cast<SizeType>(newSize);
+}
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR std::size_t VLVECTOR_BOOL_CLASS::_find(std::size_t from, bool value) const
+{
+	// Looking for a zero is looking for a one in the negated words, the padding flags which
+	// then turn up past size() are clamped away.
+	if (from >= size())
+	{
+		return size();
+	}
+	_Word negate = value? 0: ~_Word(0);
+	const _Word* words = _words.data();
+	std::size_t index = from / BITS_PER_WORD;
+	_Word word = (words[index] ^ negate) & ~vl_detail::lowBits(from % BITS_PER_WORD);
+	while (word == 0)
+	{
+		if (++index == _words.size())
+		{
+			return size();
+		}
+		word = words[index] ^ negate;
+	}
+	return std::min(index * BITS_PER_WORD + vl_detail::lowestBit(word), size());
+}
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR int VLVECTOR_BOOL_CLASS::_compare(const VLVector &other) const
+{
+	std::size_t common = std::min(size(), other.size());
+	const _Word* words = _words.data(), *otherWords = other._words.data();
+	for (std::size_t i = 0; i < _wordCount(common); ++i)
+	{
+		_Word diff = words[i] ^ otherWords[i];
+		if (diff != 0)
+		{
+			std::size_t bit = i * BITS_PER_WORD + vl_detail::lowestBit(diff);
+			if (bit >= common)
+			{
+				break;
+			}
+			return words[i] >> (bit % BITS_PER_WORD) & 1? 1: -1;
+		}
+	}
+	return size() < other.size()? -1: size() > other.size()? 1: 0;
+}
+
+VLVECTOR_BOOL_TEMPLATE
+template<class WordOp>
+VLVECTOR_CONSTEXPR VLVECTOR_BOOL_CLASS& VLVECTOR_BOOL_CLASS::_combine(const VLVector &other,
+																	  WordOp op)
+{
+	if (size() != other.size())
+	{
+		throw std::invalid_argument(SIZE_MISMATCH_ERR_MSG);
+	}
+	_Word* words = _words.data();
+	const _Word* otherWords = other._words.data();
+	for (std::size_t i = 0; i < _words.size(); ++i)
+	{
+		op(words[i], otherWords[i]);
+	}
+	return *this;
+}
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR VLVECTOR_BOOL_CLASS& VLVECTOR_BOOL_CLASS::operator=(VLVector &&other) noexcept(
+		std::is_nothrow_move_assignable<_Words>::value)
+{
+	if (&other != this)
+	{
+		_words = std::move(other._words);
+		_size = other._size;
+		other._size = 0;
+	}
+	return *this;
+}
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_BOOL_CLASS::reserve(std::size_t newCapacity)
+{
+	if (newCapacity > max_size())
+	{
+		throw std::length_error(LENGTH_ERR_MSG);
+	}
+	_words.reserve(_wordCount(newCapacity));
+}
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_BOOL_CLASS::resize(std::size_t newSize, bool value)
+{
+	if (newSize <= size())
+	{
+		_truncate(newSize);
+		return;
+	}
+	insert(cend(), newSize - size(), value);
+}
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR typename VLVECTOR_BOOL_CLASS::reference
+VLVECTOR_BOOL_CLASS::at(std::size_t index)
+{
+	if (index >= size())
+	{
+		throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
+	}
+	return (*this)[index];
+}
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR bool VLVECTOR_BOOL_CLASS::at(std::size_t index) const
+{
+	if (index >= size())
+	{
+		throw std::out_of_range(OUT_OF_RANGE_ERR_MSG);
+	}
+	return (*this)[index];
+}
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR typename VLVECTOR_BOOL_CLASS::iterator
+VLVECTOR_BOOL_CLASS::insert(const_iterator pos, std::size_t count, bool value)
+{
+	std::size_t posIdx = pos - cbegin();
+	_openGap(posIdx, count);
+	if (value)
+	{
+		vl_detail::fillBits(_words.data(), posIdx, posIdx + count, true);
+	}
+	return begin() + posIdx;
+}
+
+VLVECTOR_BOOL_TEMPLATE
+template<class InputIterator, class>
+VLVECTOR_CONSTEXPR typename VLVECTOR_BOOL_CLASS::iterator
+VLVECTOR_BOOL_CLASS::insert(const_iterator pos, InputIterator first, InputIterator last)
+{
+	std::size_t posIdx = pos - cbegin();
+	if constexpr (std::is_same<InputIterator, iterator>::value
+				  || std::is_same<InputIterator, const_iterator>::value)
+	{
+		std::size_t count = last - first;
+		_openGap(posIdx, count);
+		vl_detail::copyBits(first.words(), first.bit(), _words.data(), posIdx, count);
+	}
+	else if constexpr (std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<
+			InputIterator>::iterator_category>::value)
+	{
+		std::size_t count = std::distance(first, last);
+		_openGap(posIdx, count);
+		for (iterator dest = begin() + posIdx; first != last; ++first, ++dest)
+		{
+			*dest = static_cast<bool>(*first);
+		}
+	}
+	else
+	{
+		// The range can be read only once, so collect it and insert it in one shift.
+		VLVector flags(get_allocator());
+		for (; first != last; ++first)
+		{
+			flags.push_back(static_cast<bool>(*first));
+		}
+		insert(pos, flags.cbegin(), flags.cend());
+	}
+	return begin() + posIdx;
+}
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_BOOL_CLASS::push_back(bool value)
+{
+	if (size() == max_size())
+	{
+		throw std::length_error(LENGTH_ERR_MSG);
+	}
+	if (size() % BITS_PER_WORD == 0)
+	{
+		_words.push_back(0);
+	}
+	_words.data()[size() / BITS_PER_WORD] |= _Word(value) << (size() % BITS_PER_WORD);
+	++_size;
+}
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR typename VLVECTOR_BOOL_CLASS::iterator
+VLVECTOR_BOOL_CLASS::erase(const_iterator first, const_iterator last)
+{
+	std::size_t firstIdx = first - cbegin(), count = last - first;
+	if (count > 0)
+	{
+		// The flags before first in its word are kept aside and the word shifted with the rest.
+		_Word* words = _words.data();
+		std::size_t firstWord = firstIdx / BITS_PER_WORD;
+		_Word keptMask = vl_detail::lowBits(firstIdx % BITS_PER_WORD);
+		_Word kept = words[firstWord] & keptMask;
+		vl_detail::shiftBitsDown(words, _words.size(), firstWord, count);
+		words[firstWord] = (words[firstWord] & ~keptMask) | kept;
+		// The zeros past size() were shifted in, so the new last word is already clean.
+		_words.resize(_wordCount(size() - count));
+		_size = static_cast<SizeType>(size() - count);
+	}
+	return begin() + firstIdx;
+}
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR typename VLVECTOR_BOOL_CLASS::iterator
+VLVECTOR_BOOL_CLASS::unordered_erase(const_iterator pos)
+{
+	std::size_t idx = pos - cbegin();
+	(*this)[idx] = (*this)[size() - 1];
+	pop_back();
+	return begin() + idx;
+}
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_BOOL_CLASS::assign(std::size_t count, bool value)
+{
+	if (count > max_size())
+	{
+		throw std::length_error(LENGTH_ERR_MSG);
+	}
+	_words.assign(_wordCount(count), value? ~_Word(0): 0);
+	_size = static_cast<SizeType>(count);
+	_truncate(count);
+}
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR std::size_t VLVECTOR_BOOL_CLASS::count(bool value) const
+{
+	std::size_t set = 0;
+	for (const _Word* word = _words.data(); word != _words.data() + _words.size(); ++word)
+	{
+		set += vl_detail::popCount(*word);
+	}
+	return value? set: size() - set;
+}
+
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR void VLVECTOR_BOOL_CLASS::flip()
+{
+	for (_Word &word : _words)
+	{
+		word = ~word;
+	}
+	_truncate(size());
+}
+
+/**
+ * @param first
+ * @param second
+ * @return The flagwise and of first and second, see VLVector<bool>::operator&=.
+ */
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR VLVECTOR_BOOL_CLASS operator&(VLVECTOR_BOOL_CLASS first,
+												 const VLVECTOR_BOOL_CLASS &second)
+{
+	first &= second;
+	return first;
+}
+
+/**
+ * @param first
+ * @param second
+ * @return The flagwise or of first and second, see VLVector<bool>::operator|=.
+ */
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR VLVECTOR_BOOL_CLASS operator|(VLVECTOR_BOOL_CLASS first,
+												 const VLVECTOR_BOOL_CLASS &second)
+{
+	first |= second;
+	return first;
+}
+
+/**
+ * @param first
+ * @param second
+ * @return The flagwise exclusive or of first and second, see VLVector<bool>::operator^=.
+ */
+VLVECTOR_BOOL_TEMPLATE
+VLVECTOR_CONSTEXPR VLVECTOR_BOOL_CLASS operator^(VLVECTOR_BOOL_CLASS first,
+												 const VLVECTOR_BOOL_CLASS &second)
+{
+	first ^= second;
+	return first;
+}
+
+#undef VLVECTOR_BOOL_CLASS
+#undef VLVECTOR_BOOL_TEMPLATE
+
+#endif // VLVECTOR_BOOL_HPP
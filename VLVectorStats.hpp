@@ -0,0 +1,425 @@
+/**
+ * @author Eli Fivelzon, eli.fivelzon@mail.huji.ac.il
+ * Optional instrumentation of VLVector. Define VLVECTOR_ENABLE_STATS for the whole program
+ * (e.g. -DVLVECTOR_ENABLE_STATS) to have every VLVector instantiation count its spills to the
+ * heap, reallocations, demotions back to the stack and the element copies those cost, and
+ * a histogram of the peak size each vector reached in its lifetime, from which
+ * VLVectorStats::report recommends a StaticCapacity.
+ * With VLVECTOR_STATS_LOCATIONS too (C++20), vectors are counted per construction site.
+ * Without the macro this header is not included and VLVector has no overhead.
+ */
+#ifndef VLVECTOR_STATS_HPP
+#define VLVECTOR_STATS_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+#ifdef VLVECTOR_STATS_LOCATIONS
+#include <source_location>
+#endif
+
+/**
+ * Peak sizes up to this are counted exactly, bigger ones by powers of two.
+ */
+#define VLVECTOR_STATS_EXACT_SIZES 64
+
+/**
+ * Number of peak size buckets: the exact ones, then one per power of two above them.
+ */
+#define VLVECTOR_STATS_BUCKETS (VLVECTOR_STATS_EXACT_SIZES + 1 + 57)
+
+/**
+ * @struct VLVectorStatsSnapshot: The counters of one VLVector instantiation at some moment.
+ */
+struct VLVectorStatsSnapshot
+{
+	std::string name;				// (Demangled) type name of the instantiation.
+	std::string location;			// file:line of the construction site, if counted per site.
+	std::size_t elementSize;		// sizeof(T).
+	std::size_t staticCapacity;		// StaticCapacity.
+	std::uint64_t spills;			// Moves from the stack mem to the heap.
+	std::uint64_t reallocations;	// New heap memories, including spills and in place resizes.
+	std::uint64_t demotions;		// Moves from the heap back to the stack mem.
+	std::uint64_t elementsCopied;	// Elements copied or moved by the three above.
+	std::uint64_t bytesCopied;		// elementsCopied * elementSize.
+	std::uint64_t peakSize;			// Largest size() any vector of this type reached.
+	std::uint64_t objects;			// Vectors destroyed so far.
+	std::uint64_t spilledObjects;	// Those of them which spilled to the heap at least once.
+
+	/**
+	 * Peak sizes of the destroyed vectors: (largest peak in the bucket, vectors) pairs in
+	 * increasing order, empty buckets left out.
+	 */
+	std::vector<std::pair<std::size_t, std::uint64_t>> peakSizes;
+
+	/**
+	 * @param percentile: In [0, 1].
+	 * @return The smallest StaticCapacity for which at least percentile of the destroyed
+	 * vectors would never have spilled (rounded up to the histogram's bucket).
+	 */
+	std::size_t recommendedCapacity(double percentile) const
+	{
+		std::uint64_t covered = 0;
+		for (const std::pair<std::size_t, std::uint64_t> &bucket : peakSizes)
+		{
+			covered += bucket.second;
+			if (covered >= percentile * objects)
+			{
+				return bucket.first;
+			}
+		}
+		return peakSizes.empty()? 0: peakSizes.back().first;
+	}
+};
+
+namespace vl_detail
+{
+/**
+ * @param size
+ * @return The bucket of the peak size histogram size falls in.
+ */
+inline std::size_t peakBucket(std::size_t size)
+{
+	if (size <= VLVECTOR_STATS_EXACT_SIZES)
+	{
+		return size;
+	}
+	std::size_t bucket = VLVECTOR_STATS_EXACT_SIZES;
+	for (std::size_t bound = VLVECTOR_STATS_EXACT_SIZES; bound < size && bound << 1 != 0;
+		 bound <<= 1)
+	{
+		++bucket;
+	}
+	return bucket;
+}
+
+/**
+ * @param bucket
+ * @return The largest size in bucket.
+ */
+inline std::size_t bucketMax(std::size_t bucket)
+{
+	if (bucket <= VLVECTOR_STATS_EXACT_SIZES)
+	{
+		return bucket;
+	}
+	return std::size_t(VLVECTOR_STATS_EXACT_SIZES) << (bucket - VLVECTOR_STATS_EXACT_SIZES);
+}
+
+/**
+ * @class StatCounters: The counters of one VLVector instantiation (or construction site).
+ * Registers itself in the global registry read by VLVectorStats.
+ */
+class StatCounters
+{
+private:
+	std::string _name, _location;
+	std::size_t _elementSize, _staticCapacity;
+	std::atomic<std::uint64_t> _spills, _reallocations, _demotions, _elementsCopied, _peakSize;
+	std::atomic<std::uint64_t> _objects, _spilledObjects;
+	std::atomic<std::uint64_t> _peakBuckets[VLVECTOR_STATS_BUCKETS];
+public:
+	StatCounters(std::string name, std::size_t elementSize, std::size_t staticCapacity,
+				 std::string location = std::string());
+
+	/**
+	 * Record a new heap memory for a vector which held moved elements.
+	 * @param spill: true if the vector was on the stack mem before.
+	 * @param moved
+	 */
+	void onGrowth(bool spill, std::size_t moved)
+	{
+		_reallocations.fetch_add(1, std::memory_order_relaxed);
+		_spills.fetch_add(spill, std::memory_order_relaxed);
+		_elementsCopied.fetch_add(moved, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Record a move back to the stack mem of moved elements.
+	 * @param moved
+	 */
+	void onDemotion(std::size_t moved)
+	{
+		_demotions.fetch_add(1, std::memory_order_relaxed);
+		_elementsCopied.fetch_add(moved, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Record that a vector reached size.
+	 * @param size
+	 */
+	void onSize(std::size_t size)
+	{
+		std::uint64_t peak = _peakSize.load(std::memory_order_relaxed);
+		while (size > peak && !_peakSize.compare_exchange_weak(peak, size,
+															   std::memory_order_relaxed))
+		{
+		}
+	}
+
+	/**
+	 * Record the end of a vector's lifetime.
+	 * @param peakSize: The largest size it reached.
+	 * @param spilled: true if it spilled to the heap at least once.
+	 */
+	void onDestroy(std::size_t peakSize, bool spilled)
+	{
+		_objects.fetch_add(1, std::memory_order_relaxed);
+		_spilledObjects.fetch_add(spilled, std::memory_order_relaxed);
+		_peakBuckets[peakBucket(peakSize)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	VLVectorStatsSnapshot snapshot() const
+	{
+		std::uint64_t copied = _elementsCopied.load(std::memory_order_relaxed);
+		VLVectorStatsSnapshot result = {_name, _location, _elementSize, _staticCapacity,
+				_spills.load(std::memory_order_relaxed),
+				_reallocations.load(std::memory_order_relaxed),
+				_demotions.load(std::memory_order_relaxed), copied, copied * _elementSize,
+				_peakSize.load(std::memory_order_relaxed),
+				_objects.load(std::memory_order_relaxed),
+				_spilledObjects.load(std::memory_order_relaxed), {}};
+		for (std::size_t bucket = 0; bucket < VLVECTOR_STATS_BUCKETS; ++bucket)
+		{
+			std::uint64_t count = _peakBuckets[bucket].load(std::memory_order_relaxed);
+			if (count > 0)
+			{
+				result.peakSizes.emplace_back(bucketMax(bucket), count);
+			}
+		}
+		return result;
+	}
+
+	void reset()
+	{
+		_spills = 0;
+		_reallocations = 0;
+		_demotions = 0;
+		_elementsCopied = 0;
+		_peakSize = 0;
+		_objects = 0;
+		_spilledObjects = 0;
+		for (std::atomic<std::uint64_t> &count : _peakBuckets)
+		{
+			count = 0;
+		}
+	}
+};
+
+/**
+ * @struct StatRegistry: All the StatCounters created so far.
+ */
+struct StatRegistry
+{
+	std::mutex lock;
+	std::vector<StatCounters*> counters;
+
+	static StatRegistry& instance()
+	{
+		static StatRegistry registry;
+		return registry;
+	}
+};
+
+inline StatCounters::StatCounters(std::string name, std::size_t elementSize,
+								  std::size_t staticCapacity, std::string location):
+		_name(std::move(name)), _location(std::move(location)), _elementSize(elementSize),
+		_staticCapacity(staticCapacity), _spills(0), _reallocations(0), _demotions(0),
+		_elementsCopied(0), _peakSize(0), _objects(0), _spilledObjects(0), _peakBuckets()
+{
+	StatRegistry &registry = StatRegistry::instance();
+	std::lock_guard<std::mutex> guard(registry.lock);
+	registry.counters.push_back(this);
+}
+
+/**
+ * @class ObjectStats: The part of the instrumentation kept in each vector: where to count
+ * and what to record about it when it is destroyed.
+ */
+class ObjectStats
+{
+private:
+	StatCounters* _counters;
+	std::size_t _peakSize;
+	bool _spilled;
+public:
+	explicit ObjectStats(StatCounters &counters):
+			_counters(&counters), _peakSize(0), _spilled(false) {}
+
+	ObjectStats(const ObjectStats&) = delete;
+
+	ObjectStats& operator=(const ObjectStats&) = delete;
+
+	~ObjectStats() { _counters->onDestroy(_peakSize, _spilled); }
+
+	/**
+	 * Count this vector where other is counted, e.g. for copies of it.
+	 * @param other
+	 */
+	void inherit(const ObjectStats &other) { _counters = other._counters; }
+
+	/**
+	 * Count this vector in counters from now on.
+	 * @param counters
+	 */
+	void setCounters(StatCounters &counters) { _counters = &counters; }
+
+	void onGrowth(bool spill, std::size_t moved)
+	{
+		_spilled = _spilled || spill;
+		_counters->onGrowth(spill, moved);
+	}
+
+	/**
+	 * Record a heap memory the vector got other than by growing: by copy construction or
+	 * adoption, or taken over from another vector by a move or a swap.
+	 * @param allocated: true if the memory is a new one, counted as a spill of this vector.
+	 */
+	void onHeap(bool allocated)
+	{
+		if (allocated)
+		{
+			onGrowth(!_spilled, 0);
+		}
+		_spilled = true;
+	}
+
+	void onDemotion(std::size_t moved) { _counters->onDemotion(moved); }
+
+	void onSize(std::size_t size)
+	{
+		if (size > _peakSize)
+		{
+			_peakSize = size;
+			_counters->onSize(size);
+		}
+	}
+};
+
+/**
+ * @class SiteCounters: The StatCounters of each construction site of one instantiation.
+ */
+class SiteCounters
+{
+private:
+	std::mutex _lock;
+	std::map<std::tuple<const char*, unsigned, unsigned>, StatCounters> _sites;
+public:
+	/**
+	 * @return The counters of the site file:line:column, created on first use.
+	 */
+	StatCounters& site(const std::string &name, std::size_t elementSize,
+					   std::size_t staticCapacity, const char* file, unsigned line,
+					   unsigned column)
+	{
+		std::lock_guard<std::mutex> guard(_lock);
+		auto key = std::make_tuple(file, line, column);
+		auto found = _sites.find(key);
+		if (found == _sites.end())
+		{
+			found = _sites.emplace(std::piecewise_construct, std::forward_as_tuple(key),
+								   std::forward_as_tuple(name, elementSize, staticCapacity,
+									   std::string(file) + ":" + std::to_string(line))).first;
+		}
+		return found->second;
+	}
+};
+
+/**
+ * @return A readable name of Type.
+ */
+template<class Type>
+std::string typeName()
+{
+	const char* name = typeid(Type).name();
+#if __has_include(<cxxabi.h>)
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+	if (status == 0 && demangled != nullptr)
+	{
+		std::string result(demangled);
+		std::free(demangled);
+		return result;
+	}
+#endif
+	return name;
+}
+} // namespace vl_detail
+
+/**
+ * @class VLVectorStats: Access to the counters of all VLVector instantiations used so far.
+ */
+class VLVectorStats
+{
+public:
+	/**
+	 * @return The current counters of every instantiation which has counted something,
+	 * ready to be exported to a metrics system.
+	 */
+	static std::vector<VLVectorStatsSnapshot> snapshot()
+	{
+		vl_detail::StatRegistry &registry = vl_detail::StatRegistry::instance();
+		std::lock_guard<std::mutex> guard(registry.lock);
+		std::vector<VLVectorStatsSnapshot> result;
+		for (const vl_detail::StatCounters* counters : registry.counters)
+		{
+			result.push_back(counters->snapshot());
+		}
+		return result;
+	}
+
+	/**
+	 * Write for every counted instantiation (or site) the vectors destroyed so far, how many
+	 * of them spilled, and the StaticCapacity which would have kept percentile of them on
+	 * the stack, with its inline footprint.
+	 * @param out
+	 * @param percentile: In [0, 1].
+	 */
+	static void report(std::ostream &out, double percentile = 0.95)
+	{
+		for (const VLVectorStatsSnapshot &stats : snapshot())
+		{
+			if (stats.objects == 0)
+			{
+				continue;
+			}
+			std::size_t recommended = stats.recommendedCapacity(percentile);
+			out << stats.name;
+			if (!stats.location.empty())
+			{
+				out << " at " << stats.location;
+			}
+			out << ": " << stats.objects << " vectors, "
+				<< 100.0 * stats.spilledObjects / stats.objects << "% spilled with StaticCapacity "
+				<< stats.staticCapacity << " (" << stats.staticCapacity * stats.elementSize
+				<< " bytes), " << 100 * percentile << "% fit in StaticCapacity " << recommended
+				<< " (" << recommended * stats.elementSize << " bytes)\n";
+		}
+	}
+
+	/**
+	 * Zero all the counters, e.g. between scrapes.
+	 */
+	static void reset()
+	{
+		vl_detail::StatRegistry &registry = vl_detail::StatRegistry::instance();
+		std::lock_guard<std::mutex> guard(registry.lock);
+		for (vl_detail::StatCounters* counters : registry.counters)
+		{
+			counters->reset();
+		}
+	}
+};
+
+#endif // VLVECTOR_STATS_HPP
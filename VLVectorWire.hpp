@@ -0,0 +1,267 @@
+/**
+ * @author Eli Fivelzon, eli.fivelzon@mail.huji.ac.il
+ * Zero copy wire format for vectors of trivially copyable elements: a 16 byte VLWireHeader
+ * followed by the elements' bytes as they are in memory. VLWireMessage hands out the two
+ * pieces for one writev, VLWireView reads a received message in place and vl_wire_receive
+ * reads the payload straight into the memory of the vector which keeps it.
+ */
+#ifndef VLVECTOR_WIRE_HPP
+#define VLVECTOR_WIRE_HPP
+#include "VLVector.hpp"
+#include <array>
+#include <cstdint>
+#if __has_include(<sys/uio.h>)
+#include <sys/uio.h>
+#define VLWIRE_HAS_IOVEC
+#endif
+
+/**
+ * First field of a header, "VLV1" in native byte order, so a peer of the other byte order
+ * fails the check instead of reading swapped sizes.
+ */
+#define VLWIRE_MAGIC 0x31564C56u
+
+#define VLWIRE_FORMAT_ERR_MSG "Not a wire message of this element type."
+
+#define VLWIRE_TRUNCATED_ERR_MSG "Wire message is truncated."
+
+#define VLWIRE_ALIGNMENT_ERR_MSG "Wire payload is misaligned for the element type."
+
+#define VLWIRE_LIMIT_ERR_MSG "Wire message has more elements than the receiver accepts."
+
+/**
+ * @struct VLWireHeader: The size header of a message. Its 16 bytes keep the payload of a 16
+ * aligned receive buffer aligned for any fundamental element type.
+ */
+struct VLWireHeader
+{
+	std::uint32_t magic;
+	std::uint32_t elementSize;
+	std::uint64_t size;
+};
+
+static_assert(sizeof(VLWireHeader) == 16, "VLWireHeader must have no padding.");
+
+/**
+ * @struct VLWireBuffer: A piece of a message, to be written as is.
+ */
+struct VLWireBuffer
+{
+	const void* data;
+	std::size_t length;
+};
+
+namespace vl_detail
+{
+/**
+ * @param header
+ * @param elementSize
+ * @return The num of elements of a message, throws std::invalid_argument if header isn't of
+ * elementSize elements.
+ */
+inline std::size_t wireSize(const VLWireHeader &header, std::size_t elementSize)
+{
+	if (header.magic != VLWIRE_MAGIC || header.elementSize != elementSize
+		|| header.size > PTRDIFF_MAX / elementSize)
+	{
+		throw std::invalid_argument(VLWIRE_FORMAT_ERR_MSG);
+	}
+	return static_cast<std::size_t>(header.size);
+}
+} // namespace vl_detail
+
+/**
+ * @class VLWireMessage: The message of a vector's elements, without copying them: the header
+ * lives here, the payload is the vector's memory, so the vector must outlive the message and
+ * not reallocate meanwhile.
+ * @tparam T: Trivially copyable.
+ */
+template<class T>
+class VLWireMessage
+{
+	static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable.");
+private:
+	VLWireHeader _header;
+	const T* _payload;
+public:
+	/**
+	 * @param first: The elements, contiguous.
+	 * @param size
+	 */
+	VLWireMessage(const T *first, std::size_t size):
+			_header{VLWIRE_MAGIC, static_cast<std::uint32_t>(sizeof(T)), size},
+			_payload(first) {}
+
+	/**
+	 * @param vector: VLVector or any contiguous container of T.
+	 */
+	template<class Vector, class = decltype(std::declval<const Vector&>().data())>
+	explicit VLWireMessage(const Vector &vector): VLWireMessage(vector.data(), vector.size()) {}
+
+	const VLWireHeader& header() const { return _header; }
+
+	/**
+	 * @return The num of bytes of the whole message.
+	 */
+	std::size_t byte_size() const { return sizeof(VLWireHeader) + _header.size * sizeof(T); }
+
+	/**
+	 * @return The header and the payload, in order.
+	 */
+	std::array<VLWireBuffer, 2> buffers() const
+	{
+		return {VLWireBuffer{&_header, sizeof(VLWireHeader)},
+				VLWireBuffer{_payload, static_cast<std::size_t>(_header.size) * sizeof(T)}};
+	}
+
+#ifdef VLWIRE_HAS_IOVEC
+	/**
+	 * @return buffers() for writev(fd, message.iovecs().data(), 2).
+	 */
+	std::array<iovec, 2> iovecs() const
+	{
+		std::array<VLWireBuffer, 2> parts = buffers();
+		return {iovec{const_cast<void*>(parts[0].data), parts[0].length},
+				iovec{const_cast<void*>(parts[1].data), parts[1].length}};
+	}
+#endif
+
+	/**
+	 * Copy the message to dest, for transports without gather writes.
+	 * @param dest: Holds byte_size() bytes.
+	 * @return The end of the message in dest.
+	 */
+	unsigned char* write_to(void *dest) const
+	{
+		unsigned char* out = static_cast<unsigned char*>(dest);
+		for (const VLWireBuffer &part: buffers())
+		{
+			if (part.length > 0)
+			{
+				std::memcpy(out, part.data, part.length);
+			}
+			out += part.length;
+		}
+		return out;
+	}
+};
+
+/**
+ * @class VLWireView: Non owning view of the elements of a received message, read in place.
+ * The bytes must outlive the view.
+ * @tparam T: Trivially copyable.
+ */
+template<class T>
+class VLWireView
+{
+	static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable.");
+private:
+	const T* _data;
+	std::size_t _size;
+
+	VLWireView(const T *data, std::size_t size): _data(data), _size(size) {}
+public:
+	typedef T value_type;
+	typedef const T* const_iterator;
+
+	VLWireView(): _data(nullptr), _size(0) {}
+
+	/**
+	 * Throws std::invalid_argument if bytes aren't a whole message of T, or if its payload
+	 * isn't aligned for T (receive into a 16 aligned buffer).
+	 * @param bytes: A message, possibly followed by more bytes.
+	 * @param length
+	 * @return The view of its elements.
+	 */
+	static VLWireView parse(const void *bytes, std::size_t length);
+
+	/**
+	 * @return The num of bytes of the message the view was parsed from.
+	 */
+	std::size_t byte_size() const { return sizeof(VLWireHeader) + _size * sizeof(T); }
+
+	const T* data() const { return _data; }
+
+	std::size_t size() const { return _size; }
+
+	bool empty() const { return _size == 0; }
+
+	const T& operator[](std::size_t index) const { return _data[index]; }
+
+	const_iterator begin() const { return _data; }
+
+	const_iterator end() const { return _data + _size; }
+
+#ifdef __cpp_lib_span
+	std::span<const T> as_span() const { return {_data, _size}; }
+#endif
+
+	/**
+	 * @tparam Vector
+	 * @return An owning copy of the elements.
+	 */
+	template<class Vector = VLVector<T>>
+	Vector to_vector() const { return Vector(begin(), end()); }
+};
+
+template<class T>
+VLWireView<T> VLWireView<T>::parse(const void *bytes, std::size_t length)
+{
+	if (length < sizeof(VLWireHeader))
+	{
+		throw std::invalid_argument(VLWIRE_TRUNCATED_ERR_MSG);
+	}
+	VLWireHeader header;
+	std::memcpy(&header, bytes, sizeof(VLWireHeader));
+	std::size_t size = vl_detail::wireSize(header, sizeof(T));
+	if (size > (length - sizeof(VLWireHeader)) / sizeof(T))
+	{
+		throw std::invalid_argument(VLWIRE_TRUNCATED_ERR_MSG);
+	}
+	const unsigned char* payload = static_cast<const unsigned char*>(bytes)
+								   + sizeof(VLWireHeader);
+	if (reinterpret_cast<std::uintptr_t>(payload) % alignof(T) != 0)
+	{
+		throw std::invalid_argument(VLWIRE_ALIGNMENT_ERR_MSG);
+	}
+	return VLWireView(reinterpret_cast<const T*>(payload), size);
+}
+
+/**
+ * Receive a message into a vector: the header first, then the payload straight into the
+ * vector's memory (one exact allocation if it doesn't fit inline), so it is never copied.
+ * The allocation is a reserve, so a vector received to the heap is pinned: erasing won't move
+ * it back inline until shrink_to_fit(). Throws std::invalid_argument for a header which isn't
+ * of T or which has more than maxElements elements, before allocating anything.
+ * @tparam Vector: VLVector of a trivially copyable T.
+ * @tparam Read: void(void* dest, std::size_t length), fills dest or throws.
+ * @param read
+ * @param maxElements: The most elements accepted, the header's size comes from the peer.
+ * @param alloc: The vector's allocator.
+ * @return The received vector.
+ */
+template<class Vector, class Read>
+Vector vl_wire_receive(Read read, std::size_t maxElements,
+					   const typename Vector::allocator_type &alloc =
+							   typename Vector::allocator_type())
+{
+	typedef typename Vector::value_type T;
+	static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable.");
+	VLWireHeader header;
+	read(static_cast<void*>(&header), sizeof(VLWireHeader));
+	std::size_t size = vl_detail::wireSize(header, sizeof(T));
+	if (size > maxElements)
+	{
+		throw std::invalid_argument(VLWIRE_LIMIT_ERR_MSG);
+	}
+	Vector vector(alloc);
+	// Sizes past max_size() throw here, before anything is read.
+	vector.reserve(size);
+	if (size > 0)
+	{
+		read(static_cast<void*>(vector.append_uninitialized(size)), size * sizeof(T));
+	}
+	return vector;
+}
+
+#endif // VLVECTOR_WIRE_HPP
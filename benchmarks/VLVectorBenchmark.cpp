@@ -0,0 +1,273 @@
+/**
+ * Benchmarks of VLVector against std::vector, boost::container::small_vector and
+ * absl::InlinedVector (the last two only if their headers are found).
+ * Build and run with Google Benchmark, e.g.:
+ * g++ -std=c++17 -O2 -I. benchmarks/VLVectorBenchmark.cpp -o vlvector_bench -lbenchmark -lpthread
+ * ./vlvector_bench --benchmark_filter=PushBack
+ */
+#include "VLVector.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#if __has_include(<boost/container/small_vector.hpp>)
+#include <boost/container/small_vector.hpp>
+#define HAVE_BOOST_SMALL_VECTOR
+#endif
+#if __has_include(<absl/container/inlined_vector.h>)
+#include <absl/container/inlined_vector.h>
+#define HAVE_ABSL_INLINED_VECTOR
+#endif
+
+/**
+ * Inline capacity of all the small vectors compared here.
+ */
+#define BENCH_STATIC_CAPACITY 16
+
+/**
+ * Length of the string elements, long enough to defeat the small string optimization.
+ */
+#define BENCH_STRING_LENGTH 32
+
+/**
+ * @typedef Trivial: Trivially copyable element type.
+ */
+typedef std::uint64_t Trivial;
+
+/**
+ * @typedef NonTrivial: Element type with a heap owning copy and a noexcept move.
+ */
+typedef std::string NonTrivial;
+
+template<class T>
+using VLVec = VLVector<T, BENCH_STATIC_CAPACITY>;
+
+template<class T>
+using StdVec = std::vector<T>;
+
+#ifdef HAVE_BOOST_SMALL_VECTOR
+template<class T>
+using BoostVec = boost::container::small_vector<T, BENCH_STATIC_CAPACITY>;
+#endif
+
+#ifdef HAVE_ABSL_INLINED_VECTOR
+template<class T>
+using AbslVec = absl::InlinedVector<T, BENCH_STATIC_CAPACITY>;
+#endif
+
+/**
+ * @param i
+ * @return A value of T derived from i.
+ */
+template<class T>
+T makeValue(std::size_t i);
+
+template<>
+Trivial makeValue<Trivial>(std::size_t i) { return i * 2654435761u; }
+
+template<>
+NonTrivial makeValue<NonTrivial>(std::size_t i)
+{
+	NonTrivial value(BENCH_STRING_LENGTH, 'a');
+	value[0] = static_cast<char>('a' + i % 26);
+	return value;
+}
+
+/**
+ * @param size
+ * @return A Vec holding size values made by makeValue.
+ */
+template<class Vec>
+Vec makeFilled(std::size_t size)
+{
+	Vec vec;
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		vec.push_back(makeValue<typename Vec::value_type>(i));
+	}
+	return vec;
+}
+
+/**
+ * Build a vector of state.range(0) elements by push_back of existing values.
+ */
+template<class Vec>
+void PushBack(benchmark::State &state)
+{
+	typedef typename Vec::value_type T;
+	std::size_t size = state.range(0);
+	std::vector<T> values;
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		values.push_back(makeValue<T>(i));
+	}
+	for (auto _ : state)
+	{
+		Vec vec;
+		for (const T &value : values)
+		{
+			vec.push_back(value);
+		}
+		benchmark::DoNotOptimize(vec.data());
+	}
+	state.SetItemsProcessed(state.iterations() * size);
+}
+
+/**
+ * Build a vector of state.range(0) elements by emplace_back of fresh values.
+ */
+template<class Vec>
+void EmplaceBack(benchmark::State &state)
+{
+	typedef typename Vec::value_type T;
+	std::size_t size = state.range(0);
+	for (auto _ : state)
+	{
+		Vec vec;
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			vec.emplace_back(makeValue<T>(i));
+		}
+		benchmark::DoNotOptimize(vec.data());
+	}
+	state.SetItemsProcessed(state.iterations() * size);
+}
+
+/**
+ * Insert an element in the middle of a vector of state.range(0) elements and erase it again,
+ * exercising the shifting code of both (and, at StaticCapacity, the spill and demotion).
+ */
+template<class Vec>
+void InsertEraseMiddle(benchmark::State &state)
+{
+	typedef typename Vec::value_type T;
+	Vec vec = makeFilled<Vec>(state.range(0));
+	T value = makeValue<T>(0);
+	for (auto _ : state)
+	{
+		vec.insert(vec.begin() + vec.size() / 2, value);
+		vec.erase(vec.begin() + vec.size() / 2);
+		benchmark::DoNotOptimize(vec.data());
+	}
+}
+
+/**
+ * Copy construct a vector of state.range(0) elements.
+ */
+template<class Vec>
+void Copy(benchmark::State &state)
+{
+	const Vec source = makeFilled<Vec>(state.range(0));
+	for (auto _ : state)
+	{
+		Vec copy(source);
+		benchmark::DoNotOptimize(copy.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * Move a vector of state.range(0) elements back and forth.
+ */
+template<class Vec>
+void Move(benchmark::State &state)
+{
+	Vec first = makeFilled<Vec>(state.range(0));
+	for (auto _ : state)
+	{
+		Vec second(std::move(first));
+		benchmark::DoNotOptimize(second.data());
+		first = std::move(second);
+		benchmark::DoNotOptimize(first.data());
+	}
+}
+
+/**
+ * Read every element of a vector of state.range(0) elements.
+ */
+template<class Vec>
+void Iterate(benchmark::State &state)
+{
+	typedef typename Vec::value_type T;
+	const Vec vec = makeFilled<Vec>(state.range(0));
+	for (auto _ : state)
+	{
+		std::size_t sum = 0;
+		for (const T &value : vec)
+		{
+			if constexpr (std::is_arithmetic<T>::value)
+			{
+				sum += value;
+			}
+			else
+			{
+				sum += value.size();
+			}
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * push_back/pop_back on a vector of state.range(0) elements. At BENCH_STATIC_CAPACITY this
+ * crosses the spill and demotion boundary on every iteration, the other sizes are controls.
+ */
+template<class Vec>
+void SpillOscillation(benchmark::State &state)
+{
+	typedef typename Vec::value_type T;
+	Vec vec = makeFilled<Vec>(state.range(0));
+	T value = makeValue<T>(0);
+	for (auto _ : state)
+	{
+		vec.push_back(value);
+		benchmark::DoNotOptimize(vec.data());
+		vec.pop_back();
+		benchmark::DoNotOptimize(vec.data());
+	}
+}
+
+/**
+ * Sizes below, at, just above and far above the inline capacity.
+ */
+#define BENCH_SIZES Arg(BENCH_STATIC_CAPACITY / 2)->Arg(BENCH_STATIC_CAPACITY) \
+	->Arg(BENCH_STATIC_CAPACITY + 1)->Arg(BENCH_STATIC_CAPACITY * 4)->Arg(1024)
+
+/**
+ * Register benchmark Func for container template Vec with both element types.
+ */
+#define BENCH_CONTAINER(Func, Vec) \
+	BENCHMARK_TEMPLATE(Func, Vec<Trivial>)->BENCH_SIZES; \
+	BENCHMARK_TEMPLATE(Func, Vec<NonTrivial>)->BENCH_SIZES;
+
+#ifdef HAVE_BOOST_SMALL_VECTOR
+#define BENCH_BOOST(Func) BENCH_CONTAINER(Func, BoostVec)
+#else
+#define BENCH_BOOST(Func)
+#endif
+
+#ifdef HAVE_ABSL_INLINED_VECTOR
+#define BENCH_ABSL(Func) BENCH_CONTAINER(Func, AbslVec)
+#else
+#define BENCH_ABSL(Func)
+#endif
+
+/**
+ * Register benchmark Func for all the compared containers.
+ */
+#define BENCH_ALL(Func) \
+	BENCH_CONTAINER(Func, VLVec) \
+	BENCH_CONTAINER(Func, StdVec) \
+	BENCH_BOOST(Func) \
+	BENCH_ABSL(Func)
+
+BENCH_ALL(PushBack)
+BENCH_ALL(EmplaceBack)
+BENCH_ALL(InsertEraseMiddle)
+BENCH_ALL(Copy)
+BENCH_ALL(Move)
+BENCH_ALL(Iterate)
+BENCH_ALL(SpillOscillation)
+
+BENCHMARK_MAIN();
@@ -0,0 +1,930 @@
+/**
+ * Behaviour checks of the containers and policies, and regression tests of their exception
+ * safety and concurrency corners. Build and run with the sanitizers, e.g.:
+ * g++ -std=c++17 -g -fsanitize=address,undefined -I. tests/VLVectorTest.cpp -lpthread \
+ *     -o vlvector_test
+ * ./vlvector_test
+ */
+#include "VLVector.hpp"
+#include "VLSoAVector.hpp"
+#include "VLConcurrentVector.hpp"
+#include "VLVectorWire.hpp"
+#include "VLFlatMap.hpp"
+#include "VLHugePageAllocator.hpp"
+#include "VLDeque.hpp"
+#include "VLPoolAllocator.hpp"
+#include "VLSegmentedVector.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <cstdint>
+
+/**
+ * Copies which throw once copiesLeft runs out, and moves which may throw as far as the type
+ * system knows.
+ */
+struct Thrower
+{
+	static int copiesLeft;
+
+	std::string text;
+
+	Thrower(const char *value): text(value) {}
+
+	Thrower(const Thrower &other): text(other.text)
+	{
+		if (copiesLeft-- == 0)
+		{
+			throw std::runtime_error("copy");
+		}
+	}
+
+	Thrower(Thrower &&other) noexcept(false): text(std::move(other.text)) {}
+
+	Thrower& operator=(const Thrower&) = default;
+
+	Thrower& operator=(Thrower&&) = default;
+
+	bool operator==(const Thrower &other) const { return text == other.text; }
+};
+
+int Thrower::copiesLeft = -1;
+
+template<class Vector>
+static bool holds(const Vector &vector, std::initializer_list<const char*> texts)
+{
+	if (vector.size() != texts.size())
+	{
+		return false;
+	}
+	std::size_t i = 0;
+	for (const char* text: texts)
+	{
+		if (vector[i++].text != text)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * A middle insert or emplace into spare capacity which throws leaves the vector as it was.
+ */
+static void testInPlaceInsertThrows()
+{
+	VLVector<Thrower, 16> vector;
+	for (const char* text: {"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", "b", "c", "d"})
+	{
+		vector.emplace_back(text);
+	}
+	Thrower values[] = {"x", "y", "z"};
+	Thrower::copiesLeft = 1;
+	try
+	{
+		vector.insert(vector.begin() + 1, values, values + 3);
+		assert(false);
+	}
+	catch (const std::runtime_error&) {}
+	assert(holds(vector, {"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", "b", "c", "d"}));
+	Thrower::copiesLeft = 0;
+	try
+	{
+		vector.emplace(vector.begin() + 2, values[0]);
+		assert(false);
+	}
+	catch (const std::runtime_error&) {}
+	assert(holds(vector, {"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", "b", "c", "d"}));
+	Thrower::copiesLeft = -1;
+	vector.insert(vector.begin() + 1, values, values + 3);
+	vector.emplace(vector.begin() + 5, "e");
+	assert(holds(vector, {"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", "x", "y", "z", "b", "e", "c", "d"}));
+}
+
+/**
+ * A growth of a VLSoAVector which throws copying one column leaves the other columns as they
+ * were, even the ones which could be moved without throwing.
+ */
+static void testSoAReallocateThrows()
+{
+	VLSoAVector<std::tuple<std::string, Thrower>, 2> vector;
+	vector.emplace_back("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", "x");
+	vector.emplace_back("bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb", "y");
+	Thrower::copiesLeft = 1;
+	try
+	{
+		vector.emplace_back("c", "z");
+		assert(false);
+	}
+	catch (const std::runtime_error&) {}
+	Thrower::copiesLeft = -1;
+	assert(vector.size() == 2 && vector.capacity() == 2);
+	assert(vector.data<0>()[0] == "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa");
+	assert(vector.data<0>()[1] == "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb");
+	assert(vector.data<1>()[0].text == "x" && vector.data<1>()[1].text == "y");
+	vector.emplace_back("c", "z");
+	assert(vector.size() == 3 && vector.data<0>()[2] == "c" && vector.data<1>()[2].text == "z");
+}
+
+/**
+ * A VLConcurrentVector iterator which reached the end of the published elements, even at a
+ * segment boundary before the next segment exists, reads the ones appended later.
+ */
+static void testConcurrentTailingIterator()
+{
+	VLConcurrentVector<long> vector;
+	VLConcurrentVector<long>::const_iterator tail = vector.begin();
+	long expected = 0;
+	for (long batch = 16; batch <= 256; batch *= 2)
+	{
+		for (long i = 0; i < batch; ++i)
+		{
+			vector.push_back(expected + i);
+		}
+		for (; tail != vector.end(); ++tail)
+		{
+			assert(*tail == expected++);
+		}
+	}
+	assert(std::size_t(expected) == vector.size());
+
+	VLConcurrentVector<long> shared;
+	const long count = 100000;
+	std::thread producer([&shared, count]
+	{
+		for (long i = 0; i < count; ++i)
+		{
+			shared.push_back(i);
+		}
+	});
+	long next = 0;
+	for (VLConcurrentVector<long>::const_iterator it = shared.begin(); next < count; )
+	{
+		for (VLConcurrentVector<long>::const_iterator end = shared.end(); it != end; ++it)
+		{
+			assert(*it == next++);
+		}
+	}
+	producer.join();
+}
+
+/**
+ * Allocator which throws std::bad_alloc while fail is set.
+ */
+template<class T>
+struct FailingAllocator: std::allocator<T>
+{
+	static bool fail;
+
+	static constexpr std::size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+	template<class U>
+	struct rebind
+	{
+		typedef FailingAllocator<U> other;
+	};
+
+	FailingAllocator() = default;
+
+	template<class U>
+	FailingAllocator(const FailingAllocator<U>&) {}
+
+	T* allocate(std::size_t capacity)
+	{
+		if (fail)
+		{
+			throw std::bad_alloc();
+		}
+		return std::allocator<T>::allocate(capacity);
+	}
+};
+
+template<class T>
+bool FailingAllocator<T>::fail = false;
+
+/**
+ * A VLConcurrentVector whose segment allocation throws claims nothing: a failed flush keeps every
+ * staged element and a failed push_back leaves no hole, so once memory is back the elements
+ * pushed later are published.
+ */
+static void testConcurrentAllocationThrows()
+{
+	typedef VLConcurrentVector<std::string, FailingAllocator<std::string>> Vector;
+	Vector vector;
+	vector.reserve(16);
+	{
+		auto appender = vector.appender<64>();
+		for (int i = 0; i < 20; ++i)
+		{
+			appender.push_back(std::string(32, char('a' + i)));
+		}
+		FailingAllocator<unsigned char>::fail = true;
+		try
+		{
+			appender.flush();
+			assert(false);
+		}
+		catch (const std::bad_alloc&) {}
+		assert(appender.staged() == 20 && vector.claimed_size() == 0);
+		FailingAllocator<unsigned char>::fail = false;
+		appender.flush();
+		assert(appender.staged() == 0 && vector.size() == 20);
+		for (int i = 0; i < 20; ++i)
+		{
+			assert(vector[i] == std::string(32, char('a' + i)));
+		}
+		// Past the segment of [16, 48), so the destructor's flush needs one and swallows its
+		// failure.
+		for (int i = 0; i < 30; ++i)
+		{
+			appender.push_back("dropped");
+		}
+		FailingAllocator<unsigned char>::fail = true;
+	}
+	FailingAllocator<unsigned char>::fail = false;
+	assert(vector.size() == 20);
+	vector.push_back("after");
+	assert(vector.size() == 21 && vector[20] == "after");
+
+	Vector single;
+	for (int i = 0; i < 16; ++i)
+	{
+		single.push_back(std::string(1, char('a' + i)));
+	}
+	FailingAllocator<unsigned char>::fail = true;
+	try
+	{
+		single.push_back("q");
+		assert(false);
+	}
+	catch (const std::bad_alloc&) {}
+	FailingAllocator<unsigned char>::fail = false;
+	assert(single.claimed_size() == 16);
+	single.push_back("q");
+	single.push_back("r");
+	assert(single.size() == 18 && single[16] == "q" && single[17] == "r");
+}
+
+/**
+ * vl_wire_receive refuses a message of more elements than its limit after reading only the
+ * header, and receives one within the limit whole.
+ */
+static void testWireReceiveLimit()
+{
+	VLVector<int, 4> sent;
+	for (int i = 0; i < 100; ++i)
+	{
+		sent.push_back(i);
+	}
+	VLWireMessage<int> message(sent);
+	VLVector<unsigned char, 1024> bytes;
+	bytes.resize(message.byte_size());
+	message.write_to(bytes.data());
+	std::size_t offset = 0;
+	auto read = [&bytes, &offset](void* dest, std::size_t length)
+	{
+		assert(offset + length <= bytes.size());
+		std::memcpy(dest, bytes.data() + offset, length);
+		offset += length;
+	};
+	try
+	{
+		vl_wire_receive<VLVector<int, 4>>(read, 99);
+		assert(false);
+	}
+	catch (const std::invalid_argument&) {}
+	assert(offset == sizeof(VLWireHeader));
+	offset = 0;
+	VLVector<int, 4> received = vl_wire_receive<VLVector<int, 4>>(read, 100);
+	assert(received == sent && offset == bytes.size());
+}
+
+/**
+ * A VLFlatMap iterator assigns the values but gives the keys as const, so the order lookups
+ * depend on can't be broken through it.
+ */
+static void testFlatMapConstKeys()
+{
+	typedef VLFlatMap<int, std::string, 4> Map;
+	static_assert(std::is_same<decltype(std::declval<Map::iterator>()->first), const int&>::value,
+				  "Keys must be const through iterators.");
+	Map map{{3, "c"}, {1, "a"}, {2, "b"}};
+	Map::iterator it = map.find(2);
+	it->second = "x";
+	(*it).second += "y";
+	for (auto&& [key, value]: map)
+	{
+		value += std::to_string(key);
+	}
+	Map::const_iterator position = it;
+	assert(position == it && map.at(2) == "xy2" && map.erase(position)->first == 3);
+	assert(map.size() == 2 && map.find(1)->second == "a1" && map.find(3)->second == "c3");
+}
+
+#ifdef VLHUGE_PAGE_HAS_MMAP
+/**
+ * A mapped block which can't grow in place keeps its huge page alignment when it moves.
+ */
+static void testHugePageGrowthStaysAligned()
+{
+	std::size_t bytes = 2 * VLHUGE_PAGE_SIZE;
+	unsigned char* block = static_cast<unsigned char*>(VLHugePages::allocate(bytes));
+	for (std::size_t i = 0; i < bytes; i += 4096)
+	{
+		block[i] = static_cast<unsigned char>(i / 4096);
+	}
+	// Occupy the page after the block, if nothing does yet, so growing has to move it.
+	void* blocker = mmap(block + bytes, 4096, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	unsigned char* grown = static_cast<unsigned char*>(VLHugePages::reallocate(block, bytes,
+																			   8 * bytes));
+	assert(reinterpret_cast<std::uintptr_t>(grown) % VLHUGE_PAGE_SIZE == 0);
+	for (std::size_t i = 0; i < bytes; i += 4096)
+	{
+		assert(grown[i] == static_cast<unsigned char>(i / 4096));
+	}
+	VLHugePages::deallocate(grown, 8 * bytes);
+	if (blocker != MAP_FAILED)
+	{
+		munmap(blocker, 4096);
+	}
+}
+#endif
+
+/**
+ * Only a reserve which allocates pins a heap vector: one which fits the current memory leaves
+ * demotion back to the inline storage on.
+ */
+static void testReservePinsOnlyWhenAllocating()
+{
+	VLVector<int, 4> vector;
+	for (int i = 0; i < 10; ++i)
+	{
+		vector.push_back(i);
+	}
+	vector.reserve(0);
+	vector.reserve(vector.capacity());
+	vector.erase(vector.begin() + 2, vector.end());
+	assert(vector.capacity() == 4 && vector.size() == 2 && vector[1] == 1);
+	vector.reserve(32);
+	vector.erase(vector.begin());
+	assert(vector.capacity() == 32);
+	vector.shrink_to_fit();
+	assert(vector.capacity() == 4 && vector.size() == 1 && vector[0] == 1);
+
+	VLDeque<int, 4> deque;
+	for (int i = 0; i < 10; ++i)
+	{
+		deque.push_back(i);
+	}
+	deque.reserve(deque.size());
+	while (deque.size() > 2)
+	{
+		deque.pop_front();
+	}
+	assert(deque.capacity() == 4 && deque.front() == 8 && deque.back() == 9);
+
+	VLSoAVector<std::tuple<int, double>, 4> rows;
+	for (int i = 0; i < 10; ++i)
+	{
+		rows.emplace_back(i, i / 2.0);
+	}
+	rows.reserve(1);
+	rows.erase(rows.begin() + 2, rows.end());
+	assert(rows.capacity() == 4 && rows.data<0>()[1] == 1 && rows.data<1>()[1] == 0.5);
+}
+
+/**
+ * VLCompactLayout takes one word besides its inline slots, and its elements survive spilling
+ * to the heap, demoting back over the overlaid heap pointer, copies, moves and swaps.
+ */
+static void testCompactLayout()
+{
+	typedef VLVector<std::string, 3, VLRatioGrowth<>, std::size_t, std::allocator<std::string>,
+					 VLDemoteAtCapacity, VLCompactLayout> Strings;
+	static_assert(sizeof(Strings) == sizeof(std::size_t) + 3 * sizeof(std::string),
+				  "The compact layout adds one word.");
+	Strings vector;
+	for (int i = 0; i < 10; ++i)
+	{
+		vector.push_back(std::string(20, char('a' + i)));
+	}
+	assert(vector.size() == 10 && vector.capacity() > 3 && vector[9] == std::string(20, 'j'));
+	Strings copy(vector);
+	vector.erase(vector.begin() + 1, vector.end() - 1);
+	assert(vector.capacity() == 3 && vector.size() == 2);
+	assert(vector[0] == std::string(20, 'a') && vector[1] == std::string(20, 'j'));
+	vector.swap(copy);
+	assert(vector.size() == 10 && copy.size() == 2 && copy.capacity() == 3);
+	Strings moved(std::move(vector));
+	assert(moved.size() == 10 && moved[5] == std::string(20, 'f') && vector.empty());
+	moved = copy;
+	assert(moved == copy && moved[1] == std::string(20, 'j'));
+}
+
+/**
+ * A narrow SizeType shrinks the vector and caps max_size(): growth stops at it and a push past
+ * it throws std::length_error leaving the vector as it was.
+ */
+static void testNarrowSizeType()
+{
+	typedef VLVector<int, 4, VLRatioGrowth<>, std::uint8_t> Bytes;
+	typedef VLVector<int, 4, VLRatioGrowth<>, std::uint8_t, std::allocator<int>,
+					 VLDemoteAtCapacity, VLCompactLayout> CompactBytes;
+	static_assert(sizeof(Bytes) < sizeof(VLVector<int, 4>), "SizeType must narrow the vector.");
+	Bytes vector;
+	assert(vector.max_size() == 255);
+	for (int i = 0; i < 255; ++i)
+	{
+		vector.push_back(i);
+	}
+	assert(vector.size() == 255 && vector.capacity() == 255 && vector[254] == 254);
+	try
+	{
+		vector.push_back(255);
+		assert(false);
+	}
+	catch (const std::length_error&) {}
+	assert(vector.size() == 255 && vector[0] == 0);
+
+	// Two bits of the compact layout's size word hold its flags.
+	CompactBytes compact;
+	assert(compact.max_size() == 63);
+	for (int i = 0; i < 63; ++i)
+	{
+		compact.push_back(i);
+	}
+	try
+	{
+		compact.insert(compact.begin(), -1);
+		assert(false);
+	}
+	catch (const std::length_error&) {}
+	compact.erase(compact.begin() + 2, compact.end());
+	assert(compact.size() == 2 && compact.capacity() == 4 && compact[1] == 1);
+}
+
+/**
+ * erase_if and erase by value keep the order of the kept elements and demote once the heap
+ * vector fits inline again; unordered_erase fills the hole with the last element.
+ */
+static void testEraseIfAndUnorderedErase()
+{
+	VLVector<std::string, 4> vector;
+	for (int i = 0; i < 12; ++i)
+	{
+		vector.push_back(std::to_string(i % 6));
+	}
+	assert(erase(vector, std::string("5")) == 2 && vector.size() == 10);
+	assert(erase_if(vector, [](const std::string &text) { return text != "1" && text != "3"; })
+		   == 6);
+	assert(vector.size() == 4 && vector.capacity() == 4);
+	assert(vector[0] == "1" && vector[1] == "3" && vector[2] == "1" && vector[3] == "3");
+	assert(erase_if(vector, [](const std::string&) { return false; }) == 0 && vector.size() == 4);
+
+	vector.push_back("x");
+	VLVector<std::string, 4>::iterator it = vector.unordered_erase(vector.begin() + 1);
+	assert(it == vector.begin() + 1 && *it == "x" && vector.size() == 4);
+	assert(vector[0] == "1" && vector[2] == "1" && vector[3] == "3");
+	assert(vector.unordered_erase(vector.end() - 1) == vector.end() && vector.size() == 3);
+}
+
+/**
+ * VLBlockPool hands a freed block to the next allocation of its size class on the thread, so a
+ * vector spilling again gets the same memory, and never caches past its bound.
+ */
+static void testPoolReuseAndCap()
+{
+	VLBlockPool::flush();
+	void* block = VLBlockPool::allocate(100);
+	VLBlockPool::deallocate(block, 100);
+	std::size_t classBytes = VLBlockPool::cachedBytes();
+	assert(classBytes >= 100);
+	assert(VLBlockPool::allocate(100) == block && VLBlockPool::cachedBytes() == 0);
+
+	VLBlockPool::setMaxCachedBytes(classBytes);
+	void* other = VLBlockPool::allocate(100);
+	VLBlockPool::deallocate(block, 100);
+	VLBlockPool::deallocate(other, 100);
+	assert(VLBlockPool::cachedBytes() == classBytes);
+	assert(VLBlockPool::allocate(100) == block);
+	VLBlockPool::setMaxCachedBytes(VLPOOL_DEFAULT_MAX_CACHED_BYTES);
+
+	VLVector<int, 4, VLRatioGrowth<>, std::size_t, VLPoolAllocator<int>> vector;
+	const int* heap = nullptr;
+	for (int round = 0; round < 3; ++round)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			vector.push_back(i);
+		}
+		assert(heap == nullptr || vector.data() == heap);
+		heap = vector.data();
+		vector.clear();
+		vector.shrink_to_fit();
+		assert(vector.capacity() == 4);
+	}
+	VLBlockPool::deallocate(block, 100);
+	VLBlockPool::flush();
+	assert(VLBlockPool::cachedBytes() == 0);
+}
+
+static bool isAligned(const void* pointer, std::size_t alignment)
+{
+	return reinterpret_cast<std::uintptr_t>(pointer) % alignment == 0;
+}
+
+static void testAlignment()
+{
+	static_assert(VLPaddedGrowth<64>::grow(17, 4) == 32, "Padded growth rounds up to 64 bytes.");
+
+	VLAlignedVector<float, 64> floats;
+	assert(isAligned(floats.data(), 64));
+	for (int i = 0; i < 1000; ++i)
+	{
+		floats.push_back(float(i));
+		assert(isAligned(floats.data(), 64));
+		assert(floats.capacity() <= 64 || floats.capacity() % 16 == 0);
+	}
+	VLAlignedVector<float, 64> copy(floats);
+	assert(copy == floats && isAligned(copy.data(), 64));
+	floats.shrink_to_fit();
+	assert(isAligned(floats.data(), 64) && floats.size() == 1000 && floats[999] == 999.0f);
+
+	VLAlignedVector<char, 3, 128> chars;
+	for (int i = 0; i < 300; ++i)
+	{
+		chars.push_back('a');
+	}
+	assert(isAligned(chars.data(), 128) && chars.capacity() % 128 == 0);
+
+	VLVector<double, 4, VLRatioGrowth<>, std::size_t, std::allocator<double>, VLDemoteAtCapacity,
+			 VLCompactLayout, 16> compact;
+	for (int i = 0; i < 100; ++i)
+	{
+		compact.push_back(i);
+		assert(isAligned(compact.data(), 16));
+	}
+}
+
+static void testBoolPacking()
+{
+	VLVector<bool> flags;
+	for (std::size_t i = 0; i < 130; ++i)
+	{
+		flags.push_back(i % 3 == 0);
+	}
+	assert(flags.size() == 130 && flags.word_count() == 3 && flags.count() == 44);
+	assert((flags.words()[0] & 1) == 1 && (flags.words()[0] >> 63) == 1);
+	assert((flags.words()[1] & 1) == 0 && ((flags.words()[1] >> 2) & 1) == 1);
+	std::size_t found = 0;
+	for (std::size_t i = flags.find_first(); i < flags.size(); i = flags.find_next(i), ++found)
+	{
+		assert(i % 3 == 0);
+	}
+	assert(found == 44);
+
+	flags.insert(flags.begin() + 63, true);
+	assert(flags.size() == 131 && flags[63] && flags[64] && !flags[65] && flags[67]);
+	assert(flags[130] == (129 % 3 == 0) && flags.count() == 45);
+	flags.erase(flags.begin() + 63);
+	flags.insert(flags.begin() + 10, 70, false);
+	assert(flags.size() == 200 && flags.count() == 44 && flags.find_next(9) == 82);
+	flags.erase(flags.begin() + 10, flags.begin() + 80);
+	for (std::size_t i = 0; i < flags.size(); ++i)
+	{
+		assert(flags[i] == (i % 3 == 0));
+	}
+
+	VLVector<bool> evens;
+	for (std::size_t i = 0; i < 130; ++i)
+	{
+		evens.push_back(i % 2 == 0);
+	}
+	assert((flags & evens).count() == 22 && (flags | evens).count() == 87);
+	assert((flags ^ evens).count() == 65);
+	evens.pop_back();
+	bool threw = false;
+	try
+	{
+		flags &= evens;
+	}
+	catch (const std::invalid_argument&)
+	{
+		threw = true;
+	}
+	assert(threw);
+
+	flags.resize(64);
+	assert(flags.word_count() == 1 && flags.count() == 22);
+	flags.resize(70);
+	assert(!flags[64] && !flags[66] && flags.count() == 22);
+	flags.flip();
+	assert(flags.count() == 48 && flags[64] && !flags[63]);
+}
+
+static void testFlatBulkInsert()
+{
+	typedef VLFlatMap<int, int, 4> Map;
+	Map map{{5, 50}, {1, 10}};
+	VLVector<std::pair<int, int>> pairs;
+	pairs.push_back({3, 30});
+	pairs.push_back({5, -1});
+	pairs.push_back({3, -1});
+	pairs.push_back({0, 0});
+	map.insert(pairs.begin(), pairs.end());
+	assert(map.size() == 4 && map.at(0) == 0 && map.at(3) == 30 && map.at(5) == 50);
+
+	pairs.clear();
+	for (int key = 299; key >= 0; --key)
+	{
+		pairs.push_back({key % 150, key});
+	}
+	map.insert(pairs.begin(), pairs.end());
+	assert(map.size() == 150);
+	int expected = 0;
+	for (auto it = map.begin(); it != map.end(); ++it, ++expected)
+	{
+		assert(it->first == expected);
+		assert(it->second == (expected == 0? 0: expected == 1? 10: expected == 3? 30:
+							  expected == 5? 50: expected + 150));
+	}
+
+	VLFlatSet<int, 8> set{7, 3};
+	VLVector<int> keys;
+	for (int i = 0; i < 100; ++i)
+	{
+		keys.push_back((i * 37) % 50);
+	}
+	set.insert(keys.begin(), keys.end());
+	assert(set.size() == 50 && std::is_sorted(set.begin(), set.end()));
+	assert(*set.begin() == 0 && *(set.end() - 1) == 49);
+	set.insert({49, 60, 60, 2});
+	assert(set.size() == 51 && *(set.end() - 1) == 60);
+}
+
+/**
+ * True if deque holds the numbers [first, first + count) in order, through both indexing and
+ * iterators.
+ */
+template<class Deque>
+static bool holdsRun(const Deque &deque, int first, std::size_t count)
+{
+	if (deque.size() != count)
+	{
+		return false;
+	}
+	int expected = first;
+	for (auto it = deque.begin(); it != deque.end(); ++it, ++expected)
+	{
+		if (*it != std::to_string(expected) || deque[expected - first] != *it)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static void testDequeWraparound()
+{
+	VLDeque<std::string, 4> deque;
+	for (int i = 0; i < 3; ++i)
+	{
+		deque.push_back(std::to_string(i));
+	}
+	for (int i = 3; i < 23; ++i)
+	{
+		deque.push_back(std::to_string(i));
+		deque.pop_front();
+		assert(holdsRun(deque, i - 2, 3) && deque.capacity() == 4);
+	}
+
+	deque.push_front("19");
+	assert(holdsRun(deque, 19, 4) && deque.capacity() == 4);
+	deque.push_front("18");
+	deque.push_back("23");
+	assert(holdsRun(deque, 18, 6) && deque.capacity() > 4);
+	for (int i = 24; i < 40; ++i)
+	{
+		deque.push_back(std::to_string(i));
+		deque.pop_front();
+	}
+	deque.push_front("33");
+	assert(holdsRun(deque, 33, 7));
+
+	deque.insert(deque.begin() + 2, "x");
+	assert(deque[2] == "x" && deque[3] == "35" && deque.back() == "39");
+	deque.erase(deque.begin() + 2);
+	assert(holdsRun(deque, 33, 7));
+
+	while (deque.size() > 4)
+	{
+		deque.pop_front();
+	}
+	assert(holdsRun(deque, 36, 4) && deque.capacity() == 4);
+	deque.pop_back();
+	deque.push_front("35");
+	assert(holdsRun(deque, 35, 4) && deque.front() == "35" && deque.back() == "38");
+}
+
+static void testSegmentedFlatten()
+{
+	VLSegmentedVector<std::string, 4> segmented;
+	segmented.push_back("0");
+	const std::string* first = &segmented[0];
+	for (int i = 1; i < 100; ++i)
+	{
+		segmented.push_back(std::to_string(i));
+	}
+	assert(&segmented[0] == first && segmented.size() == 100);
+
+	std::size_t spans = 0, total = 0;
+	segmented.for_each_segment([&](const std::string* span, std::size_t count)
+							   {
+								   for (std::size_t i = 0; i < count; ++i)
+								   {
+									   assert(span[i] == std::to_string(total + i));
+								   }
+								   total += count;
+								   ++spans;
+							   });
+	assert(total == 100 && spans > 2);
+
+	VLVector<std::string, 4> copy = segmented.flatten();
+	assert(copy.size() == 100 && segmented.size() == 100 && segmented[99] == "99");
+	VLVector<std::string, 16> moved = std::move(segmented).flatten<VLVector<std::string, 16>>();
+	assert(segmented.empty() && moved.size() == 100);
+	for (std::size_t i = 0; i < moved.size(); ++i)
+	{
+		assert(copy[i] == std::to_string(i) && moved[i] == copy[i]);
+	}
+	segmented.push_back("again");
+	assert(segmented.size() == 1 && segmented.flatten()[0] == "again");
+}
+
+/**
+ * Allocate capacity strings and construct the first size of them as "0", "1", ...
+ */
+static std::string* makeStrings(std::allocator<std::string> &alloc, std::size_t size,
+								std::size_t capacity)
+{
+	std::string* mem = alloc.allocate(capacity);
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		new (mem + i) std::string(std::to_string(i));
+	}
+	return mem;
+}
+
+static void testAdopt()
+{
+	std::allocator<std::string> alloc;
+	VLVector<std::string, 4> vector;
+	vector.push_back("old");
+	std::string* mem = makeStrings(alloc, 6, 10);
+	vector.adopt(mem, 6, 10);
+	assert(vector.data() == mem && vector.size() == 6 && vector.capacity() == 10);
+	assert(vector[0] == "0" && vector[5] == "5");
+	for (int i = 6; i < 20; ++i)
+	{
+		vector.push_back(std::to_string(i));
+	}
+	assert(vector.size() == 20 && vector[9] == "9" && vector[19] == "19");
+
+	mem = makeStrings(alloc, 2, 3);
+	vector.adopt(mem, 2, 3);
+	assert(vector.data() != mem && vector.size() == 2 && vector.capacity() == 4);
+	assert(vector[0] == "0" && vector[1] == "1");
+
+	mem = makeStrings(alloc, 0, 8);
+	bool threw = false;
+	try
+	{
+		vector.adopt(mem, 9, 8);
+	}
+	catch (const std::length_error&)
+	{
+		threw = true;
+	}
+	assert(threw && vector.size() == 2);
+	alloc.deallocate(mem, 8);
+
+#ifdef __cpp_lib_span
+	VLVector<std::uint32_t, 2> words;
+	words.push_back(1);
+	words.push_back(2);
+	words.push_back(3);
+	assert(words.as_span().size() == 3 && words.as_span().data() == words.data());
+	assert(words.as_bytes().size() == 3 * sizeof(std::uint32_t));
+	assert(static_cast<const void*>(words.as_bytes().data()) == words.data());
+#endif
+}
+
+static void testHugePageVector()
+{
+	VLVector<int, 16, VLRatioGrowth<>, std::size_t, VLHugePageAllocator<int>> vector;
+	for (int i = 0; i < 1 << 20; ++i)
+	{
+		vector.push_back(i);
+	}
+	assert(vector.capacity() * sizeof(int) >= VLHUGE_PAGE_THRESHOLD);
+	VLHugePages::setCopyThreads(4);
+	VLVector<int, 16, VLRatioGrowth<>, std::size_t, VLHugePageAllocator<int>> copy(vector);
+	for (int i = 0; i < 1 << 20; i += 997)
+	{
+		assert(vector[i] == i && copy[i] == i);
+	}
+	vector.resize(10);
+	vector.shrink_to_fit();
+	assert(vector.size() == 10 && vector[9] == 9);
+
+	std::size_t bytes = 2 * VLPARALLEL_COPY_THRESHOLD + 12345;
+	VLVector<unsigned char, 16> source, dest;
+	source.resize(bytes);
+	dest.resize(bytes);
+	for (std::size_t i = 0; i < bytes; ++i)
+	{
+		source[i] = static_cast<unsigned char>(i * 31);
+	}
+	VLHugePages::copy(dest.data(), source.data(), bytes);
+	assert(std::memcmp(dest.data(), source.data(), bytes) == 0);
+	VLHugePages::setCopyThreads(0);
+	assert(VLHugePages::copyThreads() >= 1);
+}
+
+#ifdef VLVECTOR_HAS_CONSTEXPR
+typedef VLVector<int, 8, VLRatioGrowth<>, std::size_t, std::allocator<int>, VLDemoteAtCapacity,
+				 VLCompactLayout> CompactInts;
+
+/**
+ * @return Whether a vector pushed, inserted into, erased from and copied through a spill to the
+ * heap and back holds what it should, during constant evaluation.
+ */
+template<class Vector>
+constexpr bool spillsAndReturns()
+{
+	Vector vector;
+	for (int i = 0; i < 20; ++i)
+	{
+		vector.push_back(i);
+	}
+	vector.insert(vector.begin() + 1, 100);
+	Vector copy(vector);
+	bool spilled = vector.capacity() > 8 && copy == vector && copy[1] == 100 && copy[20] == 19;
+	copy.erase(copy.begin() + 3, copy.end());
+	vector = copy;
+	return spilled && copy.capacity() == 8 && vector.size() == 3 && vector[0] == 0
+		   && vector[1] == 100 && vector[2] == 1;
+}
+
+template<class Vector>
+constexpr Vector squares(int count)
+{
+	Vector vector;
+	for (int i = 0; i < count; ++i)
+	{
+		vector.push_back(i * i);
+	}
+	return vector;
+}
+
+static_assert(spillsAndReturns<VLVector<int, 8>>());
+static_assert(spillsAndReturns<CompactInts>());
+
+/**
+ * Globals built by a function returning by value, read back at compile time.
+ */
+constexpr VLVector<int, 8> squareTable = squares<VLVector<int, 8>>(8);
+constexpr CompactInts compactSquareTable = squares<CompactInts>(8);
+static_assert(squareTable.size() == 8 && squareTable[7] == 49 && squareTable.capacity() == 8);
+static_assert(compactSquareTable == squares<CompactInts>(8));
+#endif
+
+int main()
+{
+	testInPlaceInsertThrows();
+	testSoAReallocateThrows();
+	testConcurrentTailingIterator();
+	testConcurrentAllocationThrows();
+	testWireReceiveLimit();
+	testFlatMapConstKeys();
+#ifdef VLHUGE_PAGE_HAS_MMAP
+	testHugePageGrowthStaysAligned();
+#endif
+	testReservePinsOnlyWhenAllocating();
+	testCompactLayout();
+	testNarrowSizeType();
+	testEraseIfAndUnorderedErase();
+	testPoolReuseAndCap();
+	testAlignment();
+	testBoolPacking();
+	testFlatBulkInsert();
+	testDequeWraparound();
+	testSegmentedFlatten();
+	testAdopt();
+	testHugePageVector();
+	std::puts("All tests passed.");
+	return 0;
+}